@@ -0,0 +1,54 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * @brief Runs the fuzz target over the files of corpus directories without libFuzzer,
+ *        so its checks run with the tests. The target aborts on a failed check.
+ *        Usage: shadersettings_corpus DIRECTORY...
+ */
+int main(int argc, char *argv[]) {
+    int inputs = 0;
+    for (int i = 1; i < argc; ++i) {
+        const QFileInfoList files = QDir(QString::fromLocal8Bit(argv[i])).entryInfoList(QDir::Files, QDir::Name);
+        for (const QFileInfo &fileInfo : files) {
+            QFile file(fileInfo.filePath());
+            if (!file.open(QFile::ReadOnly)) {
+                fprintf(stderr, "Could not read %s\n", qPrintable(fileInfo.filePath()));
+                return EXIT_FAILURE;
+            }
+            const QByteArray data(file.readAll());
+            // Printed first, so the input is known if the target aborts.
+            fprintf(stderr, "%s\n", qPrintable(fileInfo.filePath()));
+            LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.constData()), static_cast<size_t>(data.size()));
+            ++inputs;
+        }
+    }
+    if (!inputs) {
+        fprintf(stderr, "No inputs found.\n");
+        return EXIT_FAILURE;
+    }
+    printf("Ran %d inputs.\n", inputs);
+    return EXIT_SUCCESS;
+}
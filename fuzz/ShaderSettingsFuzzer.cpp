@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ShaderSettings.h"
+#include <QElapsedTimer>
+#include <QPair>
+#include <QVector>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// Worst parse time seen per input size, bucket n holds the inputs of 2^n to 2^(n+1) - 1 bytes.
+static qint64 s_worstParse[32];
+
+/**
+ * @brief Time the parse of the input and keep the worst time per size bucket.
+ *        The parse has to stay linear, taking more than 5 ms plus FUZZ_PARSE_NS_PER_BYTE (2000 by default)
+ *        per byte is a failure. Best of 3, so a single slow run doesn't count.
+ * @param text : The input.
+ */
+static void checkParseTime(const QByteArray &text) {
+    qint64 best = -1;
+    QElapsedTimer timer;
+    for (int run = 0; run < 3; ++run) {
+        timer.start();
+        ShaderSettings parsed(text);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    int bucket = 0;
+    while (bucket < 31 && (qint64(2) << bucket) <= text.size()) {
+        ++bucket;
+    }
+    if (best > s_worstParse[bucket]) {
+        s_worstParse[bucket] = best;
+        fprintf(stderr, "Worst parse time for %lld to %lld bytes: %.3f ms\n", bucket ? 1LL << bucket : 0LL,
+                (2LL << bucket) - 1, best / 1e6);
+    }
+    static const qint64 nsPerByte = qEnvironmentVariableIsSet("FUZZ_PARSE_NS_PER_BYTE")
+        ? qEnvironmentVariableIntValue("FUZZ_PARSE_NS_PER_BYTE") : 2000;
+    if (best > 5000000 + nsPerByte * text.size()) {
+        fprintf(stderr, "Parsing %d bytes took %.3f ms, the parse time doesn't grow linearly.\n", static_cast<int>(text.size()), best / 1e6);
+        abort();
+    }
+}
+
+/**
+ * @brief Parse the input, change every value and change them back.
+ *        Aborts if the parse is too slow for the size of the input, if the parse isn't stable,
+ *        if a rejected change left the buffer modified, or if changing the values back doesn't give back the input.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    const QByteArray text(reinterpret_cast<const char *>(data), static_cast<int>(size));
+    checkParseTime(text);
+    ShaderSettings settings(text);
+    if (!settings.isConsistent()) {
+        abort();
+    }
+
+    QVector<QPair<QByteArray, QByteArray>> newValues, oldValues;
+    for (int i = 0; i < settings.settings().size(); ++i) {
+        const QByteArray &name = settings.settings().at(i).name;
+        // Every line defining a name is changed with its first definition.
+        if (settings.indexOf(name) != i) {
+            continue;
+        }
+        const QByteArray value(settings.value(i));
+        const QByteArray newValue(settings.changedValue(i));
+        if (!newValue.isEmpty() && settings.isValidValue(i, value)) {
+            newValues.append(qMakePair(name, newValue));
+            oldValues.append(qMakePair(name, value));
+        }
+    }
+    if (newValues.isEmpty()) {
+        return 0;
+    }
+
+    if (!settings.setValues(newValues)) {
+        // Rejected by the reparse check, the change must have been reverted.
+        if (settings.text() != text) {
+            abort();
+        }
+        return 0;
+    }
+    if (!settings.isConsistent()) {
+        abort();
+    }
+    if (!settings.setValues(oldValues) || settings.text() != text) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+// Description: Section guarded by defined().
+// Source: https://example.com/a
+#define A_ENABLED 1
+#if defined(A_ENABLED) && A_ENABLED > 0
+#define A_STRENGTH 1
+#ifdef A_EXTRA
+#define A_EXTRA_STRENGTH 2
+#else
+#define A_EXTRA_STRENGTH 3
+#endif
+#define A_AFTER -5
+#endif
+
+// Description: Section guarded by #ifdef.
+// Source: https://example.com/b
+#define B_ENABLED 0
+#ifdef B_FAST
+#define B_STRENGTH 9
+#define B_STRENGTH 9
+#endif
@@ -0,0 +1,11 @@
+const int SHADER_ORDER[] = int[](
+    SHADER_C,
+
+//WHITELIST="steam_app_*
+// Description: Windows line endings and an unterminated order.
+// Source: x
+#define C_ENABLED 1
+#if C_ENABLED == 1
+	#define C_VALUE  12 
+uniform int C_COUNT = 99999999999999999999;
+#define C_EMPTY
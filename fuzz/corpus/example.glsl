@@ -0,0 +1,26 @@
+const int SHADER_ORDER[] = int[](
+    SHADER_BLUR,
+    SHADER_SATURATION,
+SHADERS);
+
+//WHITELIST="kate,kcalc"
+
+// Description: Blurs the window.
+// Source: https://example.com/blur
+#define BLUR_ENABLED 0
+#if BLUR_ENABLED == 1
+// Radius of the blur, in pixels.
+#define BLUR_RADIUS 4
+// Weight of the center pixel.
+uniform float BLUR_WEIGHT = 0.25;
+#endif
+
+// Description: Changes the saturation.
+// Source: https://example.com/saturation
+#define SATURATION_ENABLED 1
+#if SATURATION_ENABLED == 1
+// Saturation per channel, 1.0 leaves the colors as they are.
+#define SATURATION_RGB vec3(1.0, 1.1, -0.9)
+uniform vec2 SATURATION_RANGE = vec2(0.0, 1.0);
+#define SATURATION_MODE luma
+#endif
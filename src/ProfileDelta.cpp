@@ -0,0 +1,240 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileDelta.h"
+#include "WhitelistMatcher.h"
+#include <QSet>
+
+static const QByteArray s_magic("#kwin-effect-shaders-profile 1");
+
+/**
+ * @brief Construct.
+ */
+ProfileDelta::ProfileDelta() {
+}
+
+/**
+ * @brief Check if a profile file is a delta, or an older full copy of the settings file.
+ * @param data : Contents of the profile file.
+ */
+bool ProfileDelta::isDelta(const QByteArray &data) {
+    return data.startsWith(s_magic);
+}
+
+/**
+ * @brief Get the values of a settings buffer that differ from the example file.
+ * @param base     : The parsed example file.
+ * @param settings : The parsed settings.
+ */
+ProfileDelta ProfileDelta::fromSettings(const ShaderSettings &base, const ShaderSettings &settings) {
+    ProfileDelta delta;
+    delta.baseHash = base.hash();
+    const QVector<ShaderSettings::Setting> &curSettings = settings.settings();
+    for (int i = 0; i < curSettings.size(); ++i) {
+        const QByteArray &name = curSettings.at(i).name;
+        // Duplicate names always hold the same value, only store the first one.
+        if (settings.indexOf(name) != i || base.indexOf(name) < 0) {
+            continue;
+        }
+        QByteArray value(settings.value(i));
+        if (value != base.value(name)) {
+            delta.values.append(qMakePair(name, value));
+        }
+    }
+    if (settings.hasOrder() && base.hasOrder()) {
+        QByteArrayList order(settings.order());
+        if (order != base.order()) {
+            delta.hasOrder = true;
+            delta.order = order;
+        }
+    }
+    if (settings.hasWhitelist() && base.hasWhitelist()) {
+        QByteArray whitelist(settings.whitelist());
+        if (whitelist != base.whitelist()) {
+            delta.hasWhitelist = true;
+            delta.whitelist = whitelist;
+        }
+    }
+    return delta;
+}
+
+/**
+ * @brief Read a profile file.
+ * @param data : Contents of the profile file.
+ * @return False if the data is not a delta profile.
+ */
+bool ProfileDelta::parse(const QByteArray &data) {
+    if (!isDelta(data)) {
+        *this = ProfileDelta();
+        return false;
+    }
+    // Keys written by newer versions are skipped.
+    parseBlock(data);
+    return true;
+}
+
+/**
+ * @brief Read NAME=VALUE lines, for example pasted by the user.
+ *        Empty lines and lines starting with # or // are ignored.
+ * @param data
+ * @return The lines that could not be read, they are skipped.
+ */
+QStringList ProfileDelta::parseBlock(const QByteArray &data) {
+    *this = ProfileDelta();
+    QStringList errors;
+    const QByteArrayList lines = data.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QByteArray curLine(lines.at(i).trimmed());
+        if (curLine.isEmpty() || curLine.startsWith('#') || curLine.startsWith("//")) {
+            continue;
+        }
+        int equals = curLine.indexOf('=');
+        if (equals < 1) {
+            errors.append(QString("Line %1 is not NAME=VALUE: %2").arg(i + 1).arg(QString::fromUtf8(curLine)));
+            continue;
+        }
+        QByteArray key(curLine.left(equals).trimmed());
+        QByteArray value(curLine.mid(equals + 1));
+        if (key == "@base") {
+            baseHash = value.trimmed();
+        } else if (key == "@order") {
+            hasOrder = true;
+            order.clear();
+            const QByteArrayList shaders = value.split(',');
+            for (const QByteArray &shader : shaders) {
+                if (!shader.trimmed().isEmpty()) {
+                    order.append(shader.trimmed());
+                }
+            }
+        } else if (key == "@whitelist") {
+            hasWhitelist = true;
+            whitelist = value;
+        } else if (!key.startsWith('@')) {
+            values.append(qMakePair(key, value.trimmed()));
+        } else {
+            errors.append(QString("Line %1 has an unknown key: %2").arg(i + 1).arg(QString::fromUtf8(key)));
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief Write the delta in the profile file format.
+ */
+QByteArray ProfileDelta::serialize() const {
+    QByteArray data(s_magic);
+    data.append("\n@base=").append(baseHash).append("\n");
+    return data.append(serializeBlock());
+}
+
+/**
+ * @brief Write the order, whitelist and NAME=VALUE lines without the profile header, as parseBlock() reads them.
+ */
+QByteArray ProfileDelta::serializeBlock() const {
+    QByteArray data;
+    if (hasOrder) {
+        data.append("@order=").append(order.join(',')).append("\n");
+    }
+    if (hasWhitelist) {
+        data.append("@whitelist=").append(whitelist).append("\n");
+    }
+    for (const QPair<QByteArray, QByteArray> &curValue : values) {
+        data.append(curValue.first).append("=").append(curValue.second).append("\n");
+    }
+    return data;
+}
+
+/**
+ * @brief Materialize the profile into a full settings buffer.
+ *        Values the example file no longer has are skipped, shaders the example file gained are
+ *        appended to the order, so a profile saved against an older example file still applies.
+ *        Everything is applied in one transaction, the buffer is parsed again once per profile.
+ * @param base : The parsed example file.
+ */
+ShaderSettings ProfileDelta::apply(const ShaderSettings &base) const {
+    ShaderSettings settings(base);
+    // Values that no longer apply are skipped instead of failing the others.
+    QVector<QPair<QByteArray, QByteArray>> validValues;
+    for (const QPair<QByteArray, QByteArray> &curValue : values) {
+        if (settings.isValidValue(settings.indexOf(curValue.first), curValue.second)) {
+            validValues.append(curValue);
+        }
+    }
+    QByteArrayList newOrder;
+    if (hasOrder && settings.hasOrder()) {
+        const QByteArrayList baseOrder = base.order();
+        QSet<QByteArray> known;
+        for (const QByteArray &shader : baseOrder) {
+            known.insert(shader);
+        }
+        // Shaders not in this order are appended by setOrder().
+        for (const QByteArray &shader : order) {
+            if (known.remove(shader)) {
+                newOrder.append(shader);
+            }
+        }
+    }
+    // Stored the way the whitelist tab saves it.
+    const QByteArray newWhitelist(WhitelistMatcher::normalize(QString::fromUtf8(whitelist)).toUtf8());
+    bool applyWhitelist = hasWhitelist && settings.hasWhitelist();
+
+    settings.begin();
+    if (!validValues.isEmpty()) {
+        settings.setValues(validValues);
+    }
+    if (!newOrder.isEmpty()) {
+        settings.setOrder(newOrder);
+    }
+    if (applyWhitelist) {
+        settings.setWhitelist(newWhitelist);
+    }
+    if (settings.commit()) {
+        return settings;
+    }
+    // Something in the profile breaks the file, keep the changes that still apply on their own.
+    if (!validValues.isEmpty()) {
+        settings.setValues(validValues);
+    }
+    if (!newOrder.isEmpty()) {
+        settings.setOrder(newOrder);
+    }
+    if (applyWhitelist) {
+        settings.setWhitelist(newWhitelist);
+    }
+    return settings;
+}
+
+/**
+ * @brief Apply every value as a single transaction, unlike apply(), nothing is changed if any value is invalid.
+ * @param settings : The settings to change.
+ * @return False if the changes were reverted, see ShaderSettings::errors().
+ */
+bool ProfileDelta::applyTo(ShaderSettings &settings) const {
+    // Join the caller's transaction if there is one.
+    bool ownTransaction = settings.begin();
+    settings.setValues(values);
+    if (hasOrder) {
+        settings.setOrder(order);
+    }
+    if (hasWhitelist) {
+        settings.setWhitelist(WhitelistMatcher::normalize(QString::fromUtf8(whitelist)).toUtf8());
+    }
+    if (ownTransaction) {
+        return settings.commit();
+    }
+    return settings.errors().isEmpty();
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILEDELTA_H
+#define PROFILEDELTA_H
+
+#include "ShaderSettings.h"
+#include <QPair>
+
+/**
+ * @brief A profile stored as the values that differ from 1_settings.glsl.example.
+ *
+ * File format, one entry per line:
+ *   #kwin-effect-shaders-profile 1
+ *   @base=HASH                   (SHA-1 of the example file the profile was saved against)
+ *   @order=FXAA,SMAA             (only if the order differs)
+ *   @whitelist=kate,kcalc        (only if the whitelist differs)
+ *   NAME=VALUE                   (every setting that differs)
+ */
+class ProfileDelta
+{
+public:
+    ProfileDelta();
+
+    static bool isDelta(const QByteArray &);
+    static ProfileDelta fromSettings(const ShaderSettings &, const ShaderSettings &);
+
+    bool parse(const QByteArray &);
+    QStringList parseBlock(const QByteArray &);
+    QByteArray serialize() const;
+    QByteArray serializeBlock() const;
+    ShaderSettings apply(const ShaderSettings &) const;
+    bool applyTo(ShaderSettings &) const;
+
+    QByteArray baseHash;
+    bool hasOrder = false;
+    QByteArrayList order;
+    bool hasWhitelist = false;
+    QByteArray whitelist;
+    QVector<QPair<QByteArray, QByteArray>> values;
+};
+#endif // PROFILEDELTA_H
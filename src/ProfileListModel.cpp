@@ -0,0 +1,259 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileListModel.h"
+#include <QDir>
+#include <algorithm>
+
+/**
+ * @brief Construct.
+ */
+ProfileListModel::ProfileListModel(QObject *parent)
+    : QAbstractListModel(parent) {
+    connect(&m_profilesWatcher, &QFileSystemWatcher::directoryChanged, this, &ProfileListModel::slotDirectoryChanged);
+}
+
+/**
+ * @brief Load the profiles from the profiles directory and start watching it.
+ * @param profilesPath : Path to the profiles directory.
+ */
+void ProfileListModel::setProfilesPath(const QString &profilesPath) {
+    if (!m_profilesPath.isEmpty()) {
+        m_profilesWatcher.removePath(m_profilesPath);
+    }
+    m_profilesPath = profilesPath;
+    beginResetModel();
+    m_profileSet = scanProfiles();
+    m_profiles = m_profileSet.values();
+    std::sort(m_profiles.begin(), m_profiles.end());
+    endResetModel();
+    if (!m_profilesPath.isEmpty()) {
+        m_profilesWatcher.addPath(m_profilesPath);
+    }
+}
+
+/**
+ * @brief Stop or resume watching the profiles directory, so writing a profile doesn't rescan the directory.
+ * @param watching
+ */
+void ProfileListModel::setWatching(bool watching) {
+    if (m_profilesPath.isEmpty()) {
+        return;
+    }
+    if (!watching) {
+        m_profilesWatcher.removePath(m_profilesPath);
+    } else if (!m_profilesWatcher.directories().contains(m_profilesPath)) {
+        m_profilesWatcher.addPath(m_profilesPath);
+    }
+}
+
+/**
+ * @brief Get the names of the .p files in the profiles directory.
+ * @return The profile names, without the .p extension.
+ */
+QSet<QString> ProfileListModel::scanProfiles() const {
+    QSet<QString> profiles;
+    if (m_profilesPath.isEmpty()) {
+        return profiles;
+    }
+    QDir profilesDir(m_profilesPath);
+    profilesDir.setNameFilters(QStringList() << "*.p");
+    profilesDir.setFilter(QDir::Files);
+    QStringList entries(profilesDir.entryList());
+    for (QString &curProfile : entries) {
+        curProfile.chop(2);
+        profiles.insert(curProfile);
+    }
+    return profiles;
+}
+
+/**
+ * @brief Something in the profiles directory changed, only apply the difference to the model.
+ */
+void ProfileListModel::slotDirectoryChanged() {
+    QSet<QString> profiles = scanProfiles();
+    const QStringList currentProfiles = m_profiles;
+    for (const QString &curProfile : currentProfiles) {
+        if (!profiles.contains(curProfile)) {
+            removeProfile(curProfile);
+            emit profileRemoved(curProfile);
+        }
+    }
+    for (const QString &curProfile : profiles) {
+        addProfile(curProfile);
+    }
+}
+
+/**
+ * @brief Find where a profile is, or would be, in the sorted list.
+ * @param profile : Name of the profile.
+ * @return The row.
+ */
+int ProfileListModel::lowerBound(const QString &profile) const {
+    return static_cast<int>(std::lower_bound(m_profiles.cbegin(), m_profiles.cend(), profile) - m_profiles.cbegin());
+}
+
+/**
+ * @brief Check if a profile exists.
+ * @param profile : Name of the profile.
+ */
+bool ProfileListModel::contains(const QString &profile) const {
+    return m_profileSet.contains(profile);
+}
+
+/**
+ * @brief Get the row of a profile.
+ * @param profile : Name of the profile.
+ * @return The row, -1 if the profile does not exist.
+ */
+int ProfileListModel::indexOf(const QString &profile) const {
+    if (!m_profileSet.contains(profile)) {
+        return -1;
+    }
+    return lowerBound(profile);
+}
+
+/**
+ * @brief Get the name of the profile on a row.
+ * @param row
+ * @return The profile name, empty if the row is out of range.
+ */
+QString ProfileListModel::profileAt(int row) const {
+    if (row < 0 || row >= m_profiles.size()) {
+        return QString();
+    }
+    return m_profiles.at(row);
+}
+
+/**
+ * @brief All profile names, sorted.
+ */
+const QStringList &ProfileListModel::profiles() const {
+    return m_profiles;
+}
+
+/**
+ * @brief Insert a profile at its sorted position.
+ * @param profile : Name of the profile.
+ * @return False if the profile already exists.
+ */
+bool ProfileListModel::addProfile(const QString &profile) {
+    if (profile.isEmpty() || m_profileSet.contains(profile)) {
+        return false;
+    }
+    int row = lowerBound(profile);
+    beginInsertRows(QModelIndex(), row, row);
+    m_profiles.insert(row, profile);
+    m_profileSet.insert(profile);
+    endInsertRows();
+    return true;
+}
+
+/**
+ * @brief Remove a profile.
+ * @param profile : Name of the profile.
+ * @return False if the profile does not exist.
+ */
+bool ProfileListModel::removeProfile(const QString &profile) {
+    int row = indexOf(profile);
+    if (row < 0) {
+        return false;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_profiles.removeAt(row);
+    m_profileSet.remove(profile);
+    endRemoveRows();
+    return true;
+}
+
+/**
+ * @brief Rename a profile, moving it to its new sorted position.
+ * @param oldProfile : Current name of the profile.
+ * @param newProfile : New name of the profile.
+ * @return False if the old profile does not exist or the new one already exists.
+ */
+bool ProfileListModel::renameProfile(const QString &oldProfile, const QString &newProfile) {
+    int oldRow = indexOf(oldProfile);
+    if (oldRow < 0 || newProfile.isEmpty() || m_profileSet.contains(newProfile)) {
+        return false;
+    }
+    int newRow = lowerBound(newProfile);
+    // Moving down, the destination row counts the row being moved.
+    bool moved = newRow != oldRow && newRow != oldRow + 1;
+    if (moved) {
+        beginMoveRows(QModelIndex(), oldRow, oldRow, QModelIndex(), newRow);
+    }
+    m_profiles.removeAt(oldRow);
+    m_profileSet.remove(oldProfile);
+    m_profiles.insert(newRow > oldRow ? newRow - 1 : newRow, newProfile);
+    m_profileSet.insert(newProfile);
+    if (moved) {
+        endMoveRows();
+    }
+    int row = indexOf(newProfile);
+    emit dataChanged(index(row), index(row));
+    return true;
+}
+
+/**
+ * @brief Number of profiles.
+ */
+int ProfileListModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_profiles.size();
+}
+
+/**
+ * @brief Get the profile name for the views.
+ */
+QVariant ProfileListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_profiles.size()) {
+        return QVariant();
+    }
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        return m_profiles.at(index.row());
+    }
+    return QVariant();
+}
+
+/**
+ * @brief The user edited a profile name, the file has to be renamed before the model is updated.
+ */
+bool ProfileListModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (!index.isValid() || role != Qt::EditRole || index.row() >= m_profiles.size()) {
+        return false;
+    }
+    QString newProfile(value.toString().trimmed());
+    QString oldProfile(m_profiles.at(index.row()));
+    if (newProfile.isEmpty() || m_profileSet.contains(newProfile)) {
+        return false;
+    }
+    emit renameRequested(oldProfile, newProfile);
+    return contains(newProfile);
+}
+
+/**
+ * @brief Profile names are editable.
+ */
+Qt::ItemFlags ProfileListModel::flags(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return QAbstractListModel::flags(index) | Qt::ItemIsEditable;
+}
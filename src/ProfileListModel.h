@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILELISTMODEL_H
+#define PROFILELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QStringList>
+
+/**
+ * @brief Sorted list of the profile names in the profiles directory.
+ *        Shared by the profile dropdown and the profile list, profiles are inserted / removed in place
+ *        and the directory is watched for profiles added or removed outside the GUI.
+ */
+class ProfileListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    ProfileListModel(QObject *parent = nullptr);
+
+    void setProfilesPath(const QString &);
+    void setWatching(bool);
+    bool contains(const QString &) const;
+    int indexOf(const QString &) const;
+    QString profileAt(int) const;
+    const QStringList &profiles() const;
+    bool addProfile(const QString &);
+    bool removeProfile(const QString &);
+    bool renameProfile(const QString &, const QString &);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+Q_SIGNALS:
+    void profileRemoved(const QString &);
+    void renameRequested(const QString &, const QString &);
+
+private:
+    int lowerBound(const QString &) const;
+    QSet<QString> scanProfiles() const;
+    void slotDirectoryChanged();
+
+    QString m_profilesPath;
+    QStringList m_profiles;
+    QSet<QString> m_profileSet;
+    QFileSystemWatcher m_profilesWatcher;
+};
+#endif // PROFILELISTMODEL_H
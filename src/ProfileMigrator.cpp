@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileMigrator.h"
+#include "ProfileDelta.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
+
+/**
+ * @brief Construct.
+ * @param base         : The parsed (new) example file.
+ * @param profilesPath : Path to the profiles directory, ending with a slash.
+ */
+ProfileMigrator::ProfileMigrator(const ShaderSettings &base, const QString &profilesPath)
+    : m_base(base)
+    // Fills m_base's hash cache before migrate() shares it between threads.
+    , m_baseHash(m_base.hash())
+    , m_profilesPath(profilesPath) {
+}
+
+/**
+ * @brief Migrate profiles in parallel.
+ * @param profiles : Names of the profiles.
+ * @param dryRun   : Only report what would change, don't write the profiles.
+ * @return One report per profile, in the same order.
+ */
+QVector<ProfileMigrator::Report> ProfileMigrator::migrate(const QStringList &profiles, bool dryRun) const {
+    QVector<Report> reports(profiles.size());
+    for (int i = 0; i < profiles.size(); ++i) {
+        reports[i].profile = profiles.at(i);
+    }
+    QtConcurrent::blockingMap(reports, [this, dryRun](Report &report) {
+        migrateProfile(report, dryRun);
+    });
+    return reports;
+}
+
+/**
+ * @brief Older versions linked 1_settings.glsl to the active profile, replace the link with a regular file
+ *        holding the profile's settings, so rewriting the profile doesn't change what kwin_effect_shaders reads.
+ * @param settingsPath : Path to 1_settings.glsl.
+ * @return False if the file is a link that could not be replaced.
+ */
+bool ProfileMigrator::materializeSettingsFile(const QString &settingsPath) const {
+    if (!QFileInfo(settingsPath).isSymLink()) {
+        return true;
+    }
+    QFile linkedFile(settingsPath);
+    if (!linkedFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QByteArray settingsData(linkedFile.readAll());
+    linkedFile.close();
+    ProfileDelta delta;
+    if (delta.parse(settingsData)) {
+        settingsData = delta.apply(m_base).text();
+    }
+    if (!QFile::remove(settingsPath)) {
+        return false;
+    }
+    QSaveFile settingsFile(settingsPath);
+    if (!settingsFile.open(QFile::WriteOnly)) {
+        return false;
+    }
+    settingsFile.write(settingsData);
+    return settingsFile.commit();
+}
+
+/**
+ * @brief Rebase a single profile.
+ * @param report : Report for the profile, the profile name must be set.
+ * @param dryRun : Only report what would change.
+ */
+void ProfileMigrator::migrateProfile(Report &report, bool dryRun) const {
+    QString profilePath(m_profilesPath);
+    profilePath.append(report.profile).append(".p");
+    QFile profileFile(profilePath);
+    if (!profileFile.open(QFile::ReadOnly)) {
+        report.failed = true;
+        return;
+    }
+    QByteArray profileData(profileFile.readAll());
+    profileFile.close();
+
+    QVector<QPair<QByteArray, QByteArray>> values;
+    QByteArrayList order;
+    bool hasOrder = false;
+    ShaderSettings settings;
+    ProfileDelta delta;
+    if (delta.parse(profileData)) {
+        // Already based on this example file.
+        if (delta.baseHash == m_baseHash) {
+            return;
+        }
+        report.oldBaseHash = delta.baseHash;
+        values = delta.values;
+        hasOrder = delta.hasOrder;
+        order = delta.order;
+    } else {
+        // Profile from an older version, a full copy of a settings file.
+        report.legacy = true;
+        ShaderSettings legacySettings(profileData);
+        const QVector<ShaderSettings::Setting> &legacyValues = legacySettings.settings();
+        for (int i = 0; i < legacyValues.size(); ++i) {
+            if (legacySettings.indexOf(legacyValues.at(i).name) == i) {
+                values.append(qMakePair(legacyValues.at(i).name, legacySettings.value(i)));
+            }
+        }
+        hasOrder = legacySettings.hasOrder();
+        order = legacySettings.order();
+        // Apply it like a delta, so values that don't fit the example file are dropped the same way.
+        delta = ProfileDelta::fromSettings(m_base, legacySettings);
+    }
+    settings = delta.apply(m_base);
+
+    for (const QPair<QByteArray, QByteArray> &curValue : values) {
+        int index = m_base.indexOf(curValue.first);
+        if (index < 0) {
+            report.droppedValues.append(curValue.first);
+        } else if (curValue.second != m_base.value(index) && !m_base.isValidValue(index, curValue.second)) {
+            // The setting changed type, for example from a number to a vec3.
+            report.invalidValues.append(curValue.first);
+        }
+    }
+    if (hasOrder) {
+        const QByteArrayList baseOrder = m_base.order();
+        QSet<QByteArray> baseShaders, shaders;
+        for (const QByteArray &shader : baseOrder) {
+            baseShaders.insert(shader);
+        }
+        for (const QByteArray &shader : order) {
+            shaders.insert(shader);
+            if (!baseShaders.contains(shader)) {
+                report.droppedShaders.append(shader);
+            }
+        }
+        for (const QByteArray &shader : baseOrder) {
+            if (!shaders.contains(shader)) {
+                report.addedShaders.append(shader);
+            }
+        }
+    }
+
+    QByteArray migratedData(ProfileDelta::fromSettings(m_base, settings).serialize());
+    report.migrated = migratedData != profileData;
+    if (!report.migrated || dryRun) {
+        return;
+    }
+    QSaveFile migratedFile(profilePath);
+    if (!migratedFile.open(QFile::WriteOnly)) {
+        report.failed = true;
+        return;
+    }
+    migratedFile.write(migratedData);
+    report.failed = !migratedFile.commit();
+}
+
+/**
+ * @brief Human readable report of the profiles that were (or would be) changed.
+ * @param reports
+ * @return One line per changed profile, empty if no profile changed.
+ */
+QString ProfileMigrator::summary(const QVector<Report> &reports) {
+    QStringList lines;
+    for (const Report &report : reports) {
+        if (report.failed) {
+            lines.append(QString("%1: could not be migrated.").arg(report.profile));
+            continue;
+        }
+        if (!report.migrated) {
+            continue;
+        }
+        QString line(report.profile);
+        line.append(report.legacy ? ": converted to the delta format" : ": rebased onto the new example file");
+        if (!report.droppedValues.isEmpty()) {
+            line.append("; dropped settings: ").append(QString::fromUtf8(report.droppedValues.join(", ")));
+        }
+        if (!report.invalidValues.isEmpty()) {
+            line.append("; dropped values that no longer fit their setting: ").append(QString::fromUtf8(report.invalidValues.join(", ")));
+        }
+        if (!report.droppedShaders.isEmpty()) {
+            line.append("; dropped shaders: ").append(QString::fromUtf8(report.droppedShaders.join(", ")));
+        }
+        if (!report.addedShaders.isEmpty()) {
+            line.append("; added shaders: ").append(QString::fromUtf8(report.addedShaders.join(", ")));
+        }
+        lines.append(line.append("."));
+    }
+    return lines.join("\n");
+}
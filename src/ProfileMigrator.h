@@ -0,0 +1,58 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILEMIGRATOR_H
+#define PROFILEMIGRATOR_H
+
+#include "ShaderSettings.h"
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Rebases profiles onto a new 1_settings.glsl.example when the shader pack is updated.
+ *        The user's values, order and whitelist are kept, values and shaders the example file no longer has are
+ *        dropped and new shaders are appended to the order. Profiles are processed in parallel.
+ */
+class ProfileMigrator
+{
+public:
+    struct Report {
+        QString profile;
+        bool migrated = false;
+        bool legacy = false;
+        bool failed = false;
+        QByteArray oldBaseHash;
+        QByteArrayList droppedValues;
+        QByteArrayList invalidValues;
+        QByteArrayList droppedShaders;
+        QByteArrayList addedShaders;
+    };
+
+    ProfileMigrator(const ShaderSettings &, const QString &);
+
+    QVector<Report> migrate(const QStringList &, bool) const;
+    bool materializeSettingsFile(const QString &) const;
+    static QString summary(const QVector<Report> &);
+
+private:
+    void migrateProfile(Report &, bool) const;
+
+    ShaderSettings m_base;
+    QByteArray m_baseHash;
+    QString m_profilesPath;
+};
+#endif // PROFILEMIGRATOR_H
@@ -0,0 +1,138 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SessionRecorder.h"
+
+static const QByteArray s_magic("#kwin-effect-shaders-session 1");
+static const QByteArrayList s_typeNames({"toggle", "set", "profile", "order", "whitelist", "paste", "save"});
+
+/**
+ * @brief Start recording, an existing file is replaced.
+ * @param path  : Path of the recording.
+ * @param state : The state the session starts from, its operations are ignored.
+ * @return False if the file could not be created.
+ */
+bool SessionRecorder::start(const QString &path, const Session &state) {
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+    QByteArray header(s_magic);
+    header.append("\n@base=").append(state.baseHash);
+    header.append("\n@profile=").append(state.profile.toUtf8().toPercentEncoding());
+    header.append("\n@autosave=").append(state.autoSave ? "1" : "0");
+    header.append("\n@settings=").append(state.settings.toPercentEncoding());
+    for (const QPair<QString, QByteArray> &profile : state.profiles) {
+        header.append("\n@profile-data=").append(profile.first.toUtf8().toPercentEncoding());
+        header.append(' ').append(profile.second.toPercentEncoding());
+    }
+    header.append("\n");
+    m_file.write(header);
+    m_file.flush();
+    m_timer.start();
+    return true;
+}
+
+/**
+ * @brief Check if operations are being recorded.
+ */
+bool SessionRecorder::isRecording() const {
+    return m_file.isOpen();
+}
+
+/**
+ * @brief Append an operation to the recording, does nothing if not recording.
+ * @param type  : The operation.
+ * @param name  : The setting, shader or profile the operation is on.
+ * @param value : The new value.
+ */
+void SessionRecorder::record(Type type, const QByteArray &name, const QByteArray &value) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+    QByteArray line(QByteArray::number(m_timer.elapsed()));
+    line.append(' ').append(typeName(type));
+    line.append(' ').append(name.toPercentEncoding());
+    line.append(' ').append(value.toPercentEncoding()).append('\n');
+    m_file.write(line);
+    // Keep the recording if the GUI crashes, that's when it's most useful.
+    m_file.flush();
+}
+
+/**
+ * @brief Read a recording.
+ * @param path    : Path of the recording.
+ * @param session : Set to the recorded session.
+ * @return False if the file could not be read or is not a recording.
+ */
+bool SessionRecorder::read(const QString &path, Session &session) {
+    session = Session();
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    const QByteArrayList lines = file.readAll().split('\n');
+    file.close();
+    if (lines.isEmpty() || lines.first().trimmed() != s_magic) {
+        return false;
+    }
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray &line = lines.at(i);
+        if (line.startsWith("@base=")) {
+            session.baseHash = line.mid(6).trimmed();
+        } else if (line.startsWith("@profile=")) {
+            session.profile = QString::fromUtf8(QByteArray::fromPercentEncoding(line.mid(9).trimmed()));
+        } else if (line.startsWith("@autosave=")) {
+            session.autoSave = line.mid(10).trimmed() == "1";
+        } else if (line.startsWith("@settings=")) {
+            session.settings = QByteArray::fromPercentEncoding(line.mid(10).trimmed());
+        } else if (line.startsWith("@profile-data=")) {
+            // An empty profile leaves the second field empty.
+            const QByteArrayList fields = line.mid(14).split(' ');
+            if (fields.size() == 2) {
+                session.profiles.append(qMakePair(QString::fromUtf8(QByteArray::fromPercentEncoding(fields.at(0))),
+                                                  QByteArray::fromPercentEncoding(fields.at(1).trimmed())));
+            }
+        } else {
+            const QByteArrayList fields = line.split(' ');
+            if (fields.size() != 4) {
+                continue;
+            }
+            int type = s_typeNames.indexOf(fields.at(1));
+            bool ok;
+            Operation operation;
+            operation.time = fields.at(0).toLongLong(&ok);
+            if (!ok || type < 0) {
+                continue;
+            }
+            operation.type = static_cast<Type>(type);
+            operation.name = QByteArray::fromPercentEncoding(fields.at(2));
+            operation.value = QByteArray::fromPercentEncoding(fields.at(3));
+            session.operations.append(operation);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Name of an operation in the recording.
+ * @param type
+ */
+QByteArray SessionRecorder::typeName(Type type) {
+    return s_typeNames.at(type);
+}
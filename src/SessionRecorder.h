@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Logs the operations of an editing session to a file, so it can be replayed later.
+ *
+ *        The file starts with the state the session started from, followed by one operation per line:
+ *        #kwin-effect-shaders-session 1
+ *        @base=<hash of 1_settings.glsl.example>
+ *        @profile=<active profile>
+ *        @autosave=<0 or 1>
+ *        @settings=<1_settings.glsl as a ProfileDelta>
+ *        @profile-data=<name> <contents of the profile file>   (one line per profile)
+ *        <milliseconds since start> <operation> <name> <value>
+ *        Names and values are percent encoded.
+ */
+class SessionRecorder
+{
+public:
+    enum Type {Toggle, Edit, Profile, Order, Whitelist, Paste, Save};
+
+    struct Operation {
+        qint64 time = 0;
+        Type type = Save;
+        QByteArray name;
+        QByteArray value;
+    };
+
+    struct Session {
+        QByteArray baseHash;
+        QString profile;
+        bool autoSave = false;
+        QByteArray settings;
+        QVector<QPair<QString, QByteArray>> profiles;
+        QVector<Operation> operations;
+    };
+
+    bool start(const QString &, const Session &);
+    bool isRecording() const;
+    void record(Type, const QByteArray &name = QByteArray(), const QByteArray &value = QByteArray());
+
+    static bool read(const QString &, Session &);
+    static QByteArray typeName(Type);
+
+private:
+    QFile m_file;
+    QElapsedTimer m_timer;
+};
+#endif // SESSIONRECORDER_H
@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SessionReplayer.h"
+#include "ProfileDelta.h"
+#include "ShadersGUI.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSemaphore>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+/**
+ * @brief Answers every connection with success, like kwin_effect_shaders after a successful reload.
+ *        Runs in its own thread, the GUI blocks while waiting for the answer.
+ */
+class StandInServer : public QThread
+{
+public:
+    QString serverName;
+    QSemaphore listening;
+    QAtomicInt requests;
+
+protected:
+    void run() override {
+        QLocalServer server;
+        QLocalServer::removeServer(serverName);
+        bool ok = server.listen(serverName);
+        listening.release();
+        if (!ok) {
+            return;
+        }
+        while (!isInterruptionRequested()) {
+            if (!server.waitForNewConnection(50)) {
+                continue;
+            }
+            while (QLocalSocket *socket = server.nextPendingConnection()) {
+                socket->write("success\n");
+                socket->waitForBytesWritten(250);
+                socket->disconnectFromServer();
+                delete socket;
+                requests.ref();
+            }
+        }
+    }
+};
+
+/**
+ * @brief Construct.
+ * @param shaderPath : The shader path to copy, the recording should be made with the same shader pack.
+ * @param maxSpeed   : Don't wait between operations like the user did.
+ */
+SessionReplayer::SessionReplayer(const QString &shaderPath, bool maxSpeed)
+    : m_shaderPath(shaderPath)
+    , m_maxSpeed(maxSpeed) {
+}
+
+/**
+ * @brief Replay a recording.
+ * @param recording : Path of the recording.
+ * @param out       : Where the report is written.
+ * @return The exit code.
+ */
+int SessionReplayer::replay(const QString &recording, QTextStream &out) {
+    SessionRecorder::Session session;
+    if (!SessionRecorder::read(recording, session)) {
+        out << "Could not read the recording " << recording << "\n";
+        return EXIT_FAILURE;
+    }
+    QTemporaryDir tempDir;
+    QString shaderPath(tempDir.path().append("/shaders/"));
+    if (!tempDir.isValid() || !copyDir(m_shaderPath, shaderPath)) {
+        out << "Could not copy " << m_shaderPath << "\n";
+        return EXIT_FAILURE;
+    }
+    QFile exampleFile(QString(shaderPath).append("1_settings.glsl.example"));
+    if (exampleFile.open(QFile::ReadOnly) && ShaderSettings(exampleFile.readAll()).hash() != session.baseHash) {
+        out << "The recording was made with a different 1_settings.glsl.example, operations might not apply." << "\n";
+    }
+    exampleFile.close();
+    if (!restoreState(session, shaderPath)) {
+        out << "Could not restore the settings and profiles of the recording." << "\n";
+        return EXIT_FAILURE;
+    }
+
+    QString settingsFile(tempDir.path().append("/settings.ini"));
+    {
+        QSettings settings(settingsFile, QSettings::IniFormat);
+        settings.setValue("ShaderPath", shaderPath);
+        settings.setValue("AutoSave", session.autoSave);
+        settings.setValue("ActiveProfile", session.profile);
+        settings.sync();
+    }
+
+    StandInServer server;
+    server.serverName = QString("kwin_effect_shaders-replay-%1").arg(QCoreApplication::applicationPid());
+    server.start();
+    server.listening.acquire();
+
+    ShadersGUI gui(settingsFile);
+    gui.setSocketName(server.serverName);
+
+    QVector<QVector<qint64>> latencies(SessionRecorder::Save + 1);
+    QVector<int> notApplied(SessionRecorder::Save + 1);
+    QElapsedTimer replayTimer, operationTimer;
+    replayTimer.start();
+    for (const SessionRecorder::Operation &operation : session.operations) {
+        qint64 wait = operation.time - replayTimer.elapsed();
+        if (!m_maxSpeed && wait > 0) {
+            QEventLoop loop;
+            QTimer::singleShot(static_cast<int>(wait), &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        operationTimer.start();
+        if (!gui.replay(operation)) {
+            notApplied[operation.type]++;
+        }
+        latencies[operation.type].append(operationTimer.nsecsElapsed());
+        // File watcher and model notifications, not part of the operation.
+        QCoreApplication::processEvents();
+    }
+    qint64 total = replayTimer.elapsed();
+
+    server.requestInterruption();
+    server.wait();
+
+    int failed = 0;
+    for (int count : notApplied) {
+        failed += count;
+    }
+    out << "Replayed " << session.operations.size() << " operations in " << total << " ms, ";
+    out << failed << " not applied, " << server.requests.loadAcquire() << " socket requests." << "\n";
+    out << QString("%1 %2 %3 %4 %5 %6 %7").arg(QString("operation"), -10).arg(QString("count"), 6)
+           .arg(QString("failed"), 6).arg(QString("p50 ms"), 10).arg(QString("p90 ms"), 10).arg(QString("p99 ms"), 10)
+           .arg(QString("max ms"), 10) << "\n";
+    for (int type = 0; type < latencies.size(); ++type) {
+        QVector<qint64> &curLatencies = latencies[type];
+        if (curLatencies.isEmpty()) {
+            continue;
+        }
+        std::sort(curLatencies.begin(), curLatencies.end());
+        out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg(QString::fromUtf8(SessionRecorder::typeName(static_cast<SessionRecorder::Type>(type))), -10)
+               .arg(curLatencies.size(), 6).arg(notApplied.at(type), 6)
+               .arg(percentile(curLatencies, 50), 10, 'f', 3).arg(percentile(curLatencies, 90), 10, 'f', 3)
+               .arg(percentile(curLatencies, 99), 10, 'f', 3).arg(curLatencies.last() / 1e6, 10, 'f', 3) << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Replace the settings file and the profiles of the copied shader path with the ones the recording started from.
+ *        Recordings made before they were part of it are replayed on the copy as it is.
+ * @param session    : The recording.
+ * @param shaderPath : The copied shader path.
+ * @return False if a file could not be written.
+ */
+bool SessionReplayer::restoreState(const SessionRecorder::Session &session, const QString &shaderPath) {
+    if (session.settings.isEmpty()) {
+        return true;
+    }
+    QFile exampleFile(QString(shaderPath).append("1_settings.glsl.example"));
+    ProfileDelta delta;
+    if (!exampleFile.open(QFile::ReadOnly) || !delta.parse(session.settings)) {
+        return false;
+    }
+    QFile settingsFile(QString(shaderPath).append("1_settings.glsl"));
+    if (!settingsFile.open(QFile::WriteOnly) || settingsFile.write(delta.apply(ShaderSettings(exampleFile.readAll())).text()) < 0) {
+        return false;
+    }
+    settingsFile.close();
+
+    QDir profilesDir(QString(shaderPath).append("p/"));
+    if (!profilesDir.mkpath(".")) {
+        return false;
+    }
+    const QStringList profiles = profilesDir.entryList(QStringList() << "*.p", QDir::Files);
+    for (const QString &profile : profiles) {
+        profilesDir.remove(profile);
+    }
+    for (const QPair<QString, QByteArray> &profile : session.profiles) {
+        QFile profileFile(profilesDir.filePath(QString(profile.first).append(".p")));
+        if (!profileFile.open(QFile::WriteOnly) || profileFile.write(profile.second) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Copy the files of a directory and its sub directories.
+ * @param source
+ * @param destination
+ */
+bool SessionReplayer::copyDir(const QString &source, const QString &destination) {
+    QDir sourceDir(source);
+    if (!sourceDir.exists() || !QDir().mkpath(destination)) {
+        return false;
+    }
+    const QFileInfoList entries = sourceDir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : entries) {
+        QString target(QDir(destination).filePath(entry.fileName()));
+        if (entry.isDir()) {
+            if (!copyDir(entry.filePath(), target)) {
+                return false;
+            }
+        } else if (!QFile::copy(entry.filePath(), target)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Nearest rank percentile.
+ * @param sorted  : Latencies in nanoseconds, sorted.
+ * @param percent
+ * @return The percentile in milliseconds.
+ */
+double SessionReplayer::percentile(const QVector<qint64> &sorted, int percent) {
+    int rank = static_cast<int>((static_cast<qint64>(sorted.size()) * percent + 99) / 100);
+    return sorted.at(qMax(rank, 1) - 1) / 1e6;
+}
@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONREPLAYER_H
+#define SESSIONREPLAYER_H
+
+#include "SessionRecorder.h"
+#include <QString>
+#include <QTextStream>
+
+/**
+ * @brief Replays a recorded session without showing the GUI and reports how long each operation took.
+ *        The session runs against a copy of the shader path with its own settings file, saves are answered
+ *        by a stand-in for the kwin_effect_shaders socket, so neither the user's files nor the compositor are touched.
+ */
+class SessionReplayer
+{
+public:
+    SessionReplayer(const QString &, bool);
+
+    int replay(const QString &, QTextStream &);
+
+private:
+    static bool copyDir(const QString &, const QString &);
+    static bool restoreState(const SessionRecorder::Session &, const QString &);
+    static double percentile(const QVector<qint64> &, int);
+
+    QString m_shaderPath;
+    bool m_maxSpeed;
+};
+#endif // SESSIONREPLAYER_H
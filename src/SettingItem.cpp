@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SettingItem.h"
+
+QCache<QByteArray, QString> SettingItem::s_tooltipCache(64);
+
+/**
+ * @brief Construct.
+ * @param text           : Text of the item.
+ * @param shaderSettings : The parsed settings the item was created from, must outlive the item.
+ * @param settingIndex   : Index of the setting in shaderSettings.
+ */
+SettingItem::SettingItem(const QString &text, const ShaderSettings *shaderSettings, int settingIndex)
+    : QTableWidgetItem(text)
+    , m_shaderSettings(shaderSettings)
+    , m_settingIndex(settingIndex) {
+}
+
+/**
+ * @brief Render the tooltip when the view asks for it.
+ */
+QVariant SettingItem::data(int role) const {
+    if (role != Qt::ToolTipRole || !m_shaderSettings) {
+        return QTableWidgetItem::data(role);
+    }
+    QByteArray tooltip(m_shaderSettings->tooltip(m_settingIndex));
+    if (tooltip.isEmpty()) {
+        return QVariant();
+    }
+    bool isShader = m_shaderSettings->settings().at(m_settingIndex).type == ShaderSettings::Enabled;
+    // The same comment can be a shader and a setting tooltip, they render differently.
+    tooltip.prepend(isShader ? 's' : 'v');
+    if (QString *html = s_tooltipCache.object(tooltip)) {
+        return *html;
+    }
+    QString html(renderTooltip(tooltip.mid(1), isShader));
+    s_tooltipCache.insert(tooltip, new QString(html));
+    return html;
+}
+
+/**
+ * @brief Turn the comment lines into HTML.
+ *        For a shader, the description is a paragraph, the source and license get their own paragraph,
+ *        for a setting, every line is a paragraph.
+ * @param comments : The raw comment lines.
+ * @param isShader : If the comments describe a shader.
+ */
+QString SettingItem::renderTooltip(const QByteArray &comments, bool isShader) {
+    QString tooltip;
+    const QStringList lines = QString::fromUtf8(comments).split("\n");
+    for (const QString &line : lines) {
+        QString curLine = line.trimmed();
+        if (!curLine.startsWith("//")) {
+            continue;
+        }
+        // Remove the leading //
+        curLine = curLine.remove(0, 2).trimmed();
+        if (!isShader) {
+            tooltip.append("<p>").append(curLine).append("</p>");
+        } else if (curLine.startsWith("Description: ")) {
+            tooltip.append("<p>").append(curLine);
+        } else if (curLine.startsWith("Source: ")) {
+            tooltip.append("</p><p>").append(curLine).append("</p>");
+        } else if (curLine.startsWith("License: ")) {
+            tooltip.append("<p>").append(curLine).append("</p>");
+        } else {
+            tooltip.append(" ").append(curLine);
+        }
+    }
+    if (tooltip.isEmpty()) {
+        return tooltip;
+    }
+    return tooltip.prepend("<html><head/><body>").append("</body></html>");
+}
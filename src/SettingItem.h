@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SETTINGITEM_H
+#define SETTINGITEM_H
+
+#include "ShaderSettings.h"
+#include <QCache>
+#include <QTableWidgetItem>
+
+/**
+ * @brief Shader table item whose tooltip is only rendered to HTML when it is requested.
+ *        The item only knows which setting it belongs to, the comment lines stay in the settings buffer,
+ *        rendered tooltips are kept in a small LRU cache shared by every item.
+ */
+class SettingItem : public QTableWidgetItem
+{
+public:
+    SettingItem(const QString &, const ShaderSettings *, int);
+
+    QVariant data(int role) const override;
+
+    static QString renderTooltip(const QByteArray &, bool);
+
+private:
+    const ShaderSettings *m_shaderSettings;
+    int m_settingIndex;
+    static QCache<QByteArray, QString> s_tooltipCache;
+};
+#endif // SETTINGITEM_H
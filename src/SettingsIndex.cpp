@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SettingsIndex.h"
+#include <algorithm>
+
+/**
+ * @brief Start updating the settings, settings not updated before endUpdate() are removed.
+ */
+void SettingsIndex::beginUpdate() {
+    for (Entry &entry : m_entries) {
+        entry.seen = false;
+    }
+}
+
+/**
+ * @brief Add or update a setting.
+ * @param name    : Name of the setting, what match() returns.
+ * @param shader  : Name of the shader the setting belongs to.
+ * @param tooltip : The comment lines describing the setting, not kept, can be a view into the settings buffer.
+ */
+void SettingsIndex::update(const QString &name, const QString &shader, const QByteArray &tooltip) {
+    size_t tooltipHash = qHash(tooltip);
+    auto it = m_entries.find(name);
+    if (it == m_entries.end()) {
+        it = m_entries.insert(name, Entry());
+    } else if (it->shader == shader && it->tooltipHash == tooltipHash && it->tooltipSize == tooltip.size()) {
+        it->seen = true;
+        return;
+    }
+    it->shader = shader;
+    it->tooltipHash = tooltipHash;
+    it->tooltipSize = tooltip.size();
+    it->tokens = tokenize(name);
+    it->tokens.append(tokenize(shader));
+    it->tokens.append(tokenize(QString::fromUtf8(tooltip)));
+    it->tokens.removeDuplicates();
+    it->seen = true;
+    m_dirty = true;
+}
+
+/**
+ * @brief Remove the settings that were not updated since beginUpdate().
+ */
+void SettingsIndex::endUpdate() {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!it->seen) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief Find the settings matching a query.
+ * @param query : Words separated by spaces or punctuation, case insensitive.
+ * @return Names of the matching settings.
+ */
+QSet<QString> SettingsIndex::match(const QString &query) const {
+    QSet<QString> matches;
+    const QStringList terms = tokenize(query);
+    if (terms.isEmpty()) {
+        return matches;
+    }
+    if (m_dirty) {
+        rebuild();
+    }
+    for (int i = 0; i < terms.size(); ++i) {
+        const QString &term = terms.at(i);
+        QSet<QString> termMatches;
+        auto it = std::lower_bound(m_tokens.cbegin(), m_tokens.cend(), qMakePair(term, QString()));
+        for (; it != m_tokens.cend() && it->first.startsWith(term); ++it) {
+            termMatches.insert(it->second);
+        }
+        if (i == 0) {
+            matches.swap(termMatches);
+        } else {
+            matches.intersect(termMatches);
+        }
+        if (matches.isEmpty()) {
+            break;
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Split text into lower cased words.
+ * @param text
+ */
+QStringList SettingsIndex::tokenize(const QString &text) {
+    QStringList tokens;
+    QString token;
+    for (const QChar &c : text) {
+        if (c.isLetterOrNumber()) {
+            token.append(c.toLower());
+        } else if (!token.isEmpty()) {
+            tokens.append(token);
+            token.clear();
+        }
+    }
+    if (!token.isEmpty()) {
+        tokens.append(token);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Rebuild the sorted token table.
+ */
+void SettingsIndex::rebuild() const {
+    m_tokens.clear();
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        for (const QString &token : it->tokens) {
+            m_tokens.append(qMakePair(token, it.key()));
+        }
+    }
+    std::sort(m_tokens.begin(), m_tokens.end());
+    m_dirty = false;
+}
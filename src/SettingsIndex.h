@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SETTINGSINDEX_H
+#define SETTINGSINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Search index over the shader settings, a sorted table of (token, setting name) pairs.
+ *        Tokens are the lower cased words of the setting name, its shader and its comments, every word of the
+ *        query has to be the prefix of a token of the setting.
+ *
+ *        Settings are updated between beginUpdate() and endUpdate(), the table is only rebuilt if a setting
+ *        was added, removed or its text changed, value edits and profile changes don't touch it.
+ *        Only a hash of the comments is kept, they are only split into words when they change.
+ */
+class SettingsIndex
+{
+public:
+    void beginUpdate();
+    void update(const QString &, const QString &, const QByteArray &);
+    void endUpdate();
+    QSet<QString> match(const QString &) const;
+
+private:
+    struct Entry {
+        QString shader;
+        size_t tooltipHash = 0;
+        int tooltipSize = 0;
+        QStringList tokens;
+        bool seen = false;
+    };
+
+    static QStringList tokenize(const QString &);
+    void rebuild() const;
+
+    QHash<QString, Entry> m_entries;
+    mutable QVector<QPair<QString, QString>> m_tokens;
+    mutable bool m_dirty = false;
+};
+#endif // SETTINGSINDEX_H
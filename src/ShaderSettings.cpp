@@ -0,0 +1,792 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ShaderSettings.h"
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static bool isNameChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool isDigits(const QByteArray &value) {
+    if (value.isEmpty()) {
+        return false;
+    }
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Construct.
+ */
+ShaderSettings::ShaderSettings() {
+}
+
+/**
+ * @brief Construct and parse.
+ * @param text : Contents of a settings file.
+ */
+ShaderSettings::ShaderSettings(const QByteArray &text) {
+    setText(text);
+}
+
+/**
+ * @brief Replace the buffer and parse it.
+ * @param text : Contents of a settings file.
+ */
+void ShaderSettings::setText(const QByteArray &text) {
+    m_inTransaction = false;
+    m_snapshot = Snapshot();
+    m_errors.clear();
+    m_text = text;
+    m_hash.clear();
+    parse();
+}
+
+/**
+ * @brief The (edited) buffer.
+ */
+const QByteArray &ShaderSettings::text() const {
+    return m_text;
+}
+
+/**
+ * @brief Hash of the buffer, used to know which example file a profile is based on.
+ *        Computed once per buffer, every profile save asks for the example file's hash.
+ *        The first call writes the cache, call it before sharing the object between threads.
+ * @return Hex encoded SHA-1.
+ */
+QByteArray ShaderSettings::hash() const {
+    if (m_hash.isEmpty()) {
+        m_hash = QCryptographicHash::hash(m_text, QCryptographicHash::Sha1).toHex();
+    }
+    return m_hash;
+}
+
+/**
+ * @brief All settings, in the order they appear in the buffer.
+ */
+const QVector<ShaderSettings::Setting> &ShaderSettings::settings() const {
+    return m_settings;
+}
+
+/**
+ * @brief Find a setting by name.
+ * @param name : The define / uniform name, for shaders the NAME_ENABLED define.
+ * @return Index of the first setting with that name, -1 if not found.
+ */
+int ShaderSettings::indexOf(const QByteArray &name) const {
+    return m_index.value(name, -1);
+}
+
+/**
+ * @brief Get the value of a setting.
+ * @param index
+ */
+QByteArray ShaderSettings::value(int index) const {
+    if (index < 0 || index >= m_settings.size()) {
+        return QByteArray();
+    }
+    return bytes(m_settings.at(index).value);
+}
+
+/**
+ * @brief Get the value of a setting.
+ * @param name
+ */
+QByteArray ShaderSettings::value(const QByteArray &name) const {
+    return value(indexOf(name));
+}
+
+/**
+ * @brief Get the comment lines describing a setting, or for shaders, the description and source.
+ * @param index
+ * @return The raw lines, including the leading //.
+ */
+QByteArray ShaderSettings::tooltip(int index) const {
+    if (index < 0 || index >= m_settings.size()) {
+        return QByteArray();
+    }
+    return bytes(m_settings.at(index).tooltip);
+}
+
+/**
+ * @brief Like tooltip(), without copying the lines out of the buffer.
+ * @param index
+ * @return The raw lines, only valid until the buffer changes.
+ */
+QByteArray ShaderSettings::tooltipView(int index) const {
+    if (index < 0 || index >= m_settings.size() || !m_settings.at(index).tooltip.isValid()) {
+        return QByteArray();
+    }
+    const Span &span = m_settings.at(index).tooltip;
+    return QByteArray::fromRawData(m_text.constData() + span.start, span.length);
+}
+
+/**
+ * @brief Check a new value against the kind of value the setting currently has.
+ *        Shaders are 0 or 1, vec2 / vec3 uniforms keep their type, numbers stay numbers.
+ * @param index : Index of the setting.
+ * @param value : The new value.
+ */
+bool ShaderSettings::isValidValue(int index, const QByteArray &value) const {
+    // Surrounding white space would not be part of the value when the buffer is parsed again.
+    if (index < 0 || index >= m_settings.size() || value.isEmpty() || value != value.trimmed() || value.contains('\n')) {
+        return false;
+    }
+    const Setting &setting = m_settings.at(index);
+    if (setting.type == Enabled) {
+        return value == "0" || value == "1";
+    }
+    const QRegularExpression numberRegex("^(-?\\d+|-?\\d+\\.\\d+)$");
+    QString current(QString::fromUtf8(bytes(setting.value)));
+    QString verificationRegex;
+    if (current.startsWith("vec3(")) {
+        verificationRegex = "^vec3\\((-?\\d+\\.\\d+\\,\\s*){2}-?\\d+\\.\\d+\\)$";
+    } else if (current.startsWith("vec2(")) {
+        verificationRegex = "^vec2\\(-?\\d+\\.\\d+\\,\\s*-?\\d+\\.\\d+\\)$";
+    } else if (numberRegex.match(current).hasMatch()) {
+        verificationRegex = numberRegex.pattern();
+    } else {
+        // Anything else, as long as the line still parses.
+        verificationRegex = setting.type == Define ? "^\\S+$" : "^[^;]+$";
+    }
+    return QRegularExpression(verificationRegex).match(QString::fromUtf8(value)).hasMatch();
+}
+
+/**
+ * @brief A different value of the same type as the current one, to check that edits round trip.
+ *        Shaders are toggled, otherwise the first number is incremented (for a decimal or a vec, its
+ *        integer part), values without a number get a 1 appended.
+ * @param index : Index of the setting.
+ * @return The new value, empty if none is valid.
+ */
+QByteArray ShaderSettings::changedValue(int index) const {
+    if (index < 0 || index >= m_settings.size()) {
+        return QByteArray();
+    }
+    const QByteArray value(bytes(m_settings.at(index).value));
+    QByteArray newValue;
+    if (m_settings.at(index).type == Enabled) {
+        newValue = value == "1" ? "0" : "1";
+    } else {
+        int start = 0;
+        while (start < value.size() && (value.at(start) < '0' || value.at(start) > '9')) {
+            ++start;
+        }
+        int end = start;
+        while (end < value.size() && value.at(end) >= '0' && value.at(end) <= '9') {
+            ++end;
+        }
+        if (start == end) {
+            newValue = QByteArray(value).append('1');
+        } else {
+            bool ok;
+            qulonglong number = value.mid(start, end - start).toULongLong(&ok);
+            // Too large for a number, change its last digit.
+            QByteArray digits(ok ? QByteArray::number(number + 1) : value.mid(start, end - start));
+            if (!ok) {
+                char last = digits.at(digits.size() - 1);
+                digits[digits.size() - 1] = last == '9' ? '0' : last + 1;
+            }
+            newValue = QByteArray(value).replace(start, end - start, digits);
+        }
+    }
+    if (newValue == value || !isValidValue(index, newValue)) {
+        return QByteArray();
+    }
+    return newValue;
+}
+
+/**
+ * @brief Change the value of a setting, like the regex replacements, every line defining that name is changed.
+ * @param name
+ * @param value
+ * @return False if the setting does not exist or the value is invalid.
+ */
+bool ShaderSettings::setValue(const QByteArray &name, const QByteArray &value) {
+    return setValues(QVector<QPair<QByteArray, QByteArray>>() << qMakePair(name, value));
+}
+
+/**
+ * @brief Change the values of several settings, the buffer is rebuilt once instead of once per value.
+ *        If a name is listed twice, the last value is used.
+ * @param values : Names and values.
+ * @return False if a setting does not exist or a value is invalid, the other values are still changed
+ *         if this is part of a transaction, see commit().
+ */
+bool ShaderSettings::setValues(const QVector<QPair<QByteArray, QByteArray>> &values) {
+    bool ownTransaction = begin();
+    int errorCount = m_errors.size();
+    QHash<QByteArray, QByteArray> newValues;
+    for (const QPair<QByteArray, QByteArray> &curValue : values) {
+        int index = indexOf(curValue.first);
+        if (index < 0) {
+            fail(QString("Unknown setting %1.").arg(QString::fromUtf8(curValue.first)));
+        } else if (!isValidValue(index, curValue.second)) {
+            fail(QString("Invalid value %1 for %2.").arg(QString::fromUtf8(curValue.second), QString::fromUtf8(curValue.first)));
+        } else {
+            newValues.insert(curValue.first, curValue.second);
+        }
+    }
+    if (newValues.isEmpty()) {
+        return finish(ownTransaction, errorCount);
+    }
+
+    // Settings are in buffer order, so are their values, copy the buffer once with every value replaced.
+    QVector<int> editStarts, editShifts;
+    QByteArray text;
+    text.reserve(m_text.size());
+    int copied = 0, shift = 0;
+    for (Setting &curSetting : m_settings) {
+        auto newValue = newValues.constFind(curSetting.name);
+        if (newValue == newValues.constEnd()) {
+            continue;
+        }
+        Span &span = curSetting.value;
+        text.append(m_text.constData() + copied, span.start - copied);
+        text.append(*newValue);
+        copied = span.start + span.length;
+        shift += newValue->size() - span.length;
+        editStarts.append(span.start);
+        editShifts.append(shift);
+        span.length = newValue->size();
+    }
+    text.append(m_text.constData() + copied, m_text.size() - copied);
+    m_text.swap(text);
+    m_hash.clear();
+
+    // Move every span by the size changes of the values before it.
+    auto move = [&editStarts, &editShifts](Span &span) {
+        if (!span.isValid()) {
+            return;
+        }
+        auto it = std::lower_bound(editStarts.cbegin(), editStarts.cend(), span.start);
+        if (it != editStarts.cbegin()) {
+            span.start += editShifts.at(static_cast<int>(it - editStarts.cbegin()) - 1);
+        }
+    };
+    for (Setting &curSetting : m_settings) {
+        move(curSetting.value);
+        move(curSetting.tooltip);
+    }
+    move(m_order);
+    move(m_whitelist);
+    return finish(ownTransaction, errorCount);
+}
+
+/**
+ * @brief Enable or disable a shader.
+ * @param shader  : Shader name without the SHADER_ prefix.
+ * @param enabled
+ */
+bool ShaderSettings::setEnabled(const QByteArray &shader, bool enabled) {
+    return setValue(QByteArray(shader).append("_ENABLED"), enabled ? "1" : "0");
+}
+
+/**
+ * @brief If the buffer has a SHADER_ORDER block.
+ */
+bool ShaderSettings::hasOrder() const {
+    return m_order.isValid();
+}
+
+/**
+ * @brief Get the shader order.
+ * @return Shader names without the SHADER_ prefix.
+ */
+QByteArrayList ShaderSettings::order() const {
+    QByteArrayList order;
+    const QByteArrayList lines = bytes(m_order).split('\n');
+    for (const QByteArray &curLine : lines) {
+        QByteArray shader = curLine.trimmed();
+        if (!shader.startsWith("SHADER_")) {
+            continue;
+        }
+        shader.remove(0, 7);
+        if (shader.endsWith(',')) {
+            shader.chop(1);
+        }
+        order.append(shader);
+    }
+    return order;
+}
+
+/**
+ * @brief Replace the shader order.
+ *        Shaders missing from the new order keep their current relative order after the listed ones.
+ * @param order : Shader names without the SHADER_ prefix.
+ * @return False if a shader is unknown or listed twice.
+ */
+bool ShaderSettings::setOrder(const QByteArrayList &order) {
+    bool ownTransaction = begin();
+    int errorCount = m_errors.size();
+    if (!m_order.isValid() || order.isEmpty()) {
+        fail("There is no shader order to change.");
+        return finish(ownTransaction, errorCount);
+    }
+    const QByteArrayList currentOrder = this->order();
+    QSet<QByteArray> known, listed;
+    for (const QByteArray &shader : currentOrder) {
+        known.insert(shader);
+    }
+    QByteArray block("\n");
+    for (const QByteArray &shader : order) {
+        if (!known.contains(shader)) {
+            fail(QString("Unknown shader %1 in the order.").arg(QString::fromUtf8(shader)));
+            return finish(ownTransaction, errorCount);
+        }
+        if (listed.contains(shader)) {
+            fail(QString("Shader %1 is listed twice in the order.").arg(QString::fromUtf8(shader)));
+            return finish(ownTransaction, errorCount);
+        }
+        listed.insert(shader);
+        block.append("    SHADER_").append(shader).append(",\n");
+    }
+    for (const QByteArray &shader : currentOrder) {
+        if (!listed.contains(shader)) {
+            block.append("    SHADER_").append(shader).append(",\n");
+        }
+    }
+    block.append("\n");
+    replace(m_order, block);
+    return finish(ownTransaction, errorCount);
+}
+
+/**
+ * @brief If the buffer has a //WHITELIST="" line.
+ */
+bool ShaderSettings::hasWhitelist() const {
+    return m_whitelist.isValid();
+}
+
+/**
+ * @brief Get the whitelist, without the quotes.
+ */
+QByteArray ShaderSettings::whitelist() const {
+    return bytes(m_whitelist);
+}
+
+/**
+ * @brief Replace the whitelist.
+ * @param whitelist : The whitelist, without the quotes.
+ */
+bool ShaderSettings::setWhitelist(const QByteArray &whitelist) {
+    bool ownTransaction = begin();
+    int errorCount = m_errors.size();
+    if (!m_whitelist.isValid()) {
+        fail("There is no whitelist to change.");
+    } else if (whitelist.contains('\n') || whitelist.contains('"')) {
+        fail("The whitelist can not contain new lines or quotes.");
+    } else {
+        replace(m_whitelist, whitelist);
+    }
+    return finish(ownTransaction, errorCount);
+}
+
+/**
+ * @brief Start a transaction.
+ * @return False if a transaction is already running.
+ */
+bool ShaderSettings::begin() {
+    if (m_inTransaction) {
+        return false;
+    }
+    m_snapshot.text = m_text;
+    m_snapshot.settings = m_settings;
+    m_snapshot.order = m_order;
+    m_snapshot.whitelist = m_whitelist;
+    m_errors.clear();
+    m_inTransaction = true;
+    return true;
+}
+
+/**
+ * @brief End a transaction, if any change in it failed, every change is reverted.
+ * @return False if the transaction was reverted, see errors().
+ */
+bool ShaderSettings::commit() {
+    if (!m_inTransaction) {
+        return false;
+    }
+    if (m_errors.isEmpty() && !isConsistent()) {
+        m_errors.append("The change would make the settings file unreadable.");
+    }
+    if (!m_errors.isEmpty()) {
+        QStringList errors(m_errors);
+        rollback();
+        m_errors = errors;
+        return false;
+    }
+    m_inTransaction = false;
+    m_snapshot = Snapshot();
+    return true;
+}
+
+/**
+ * @brief Revert every change since begin().
+ */
+void ShaderSettings::rollback() {
+    if (!m_inTransaction) {
+        return;
+    }
+    m_text = m_snapshot.text;
+    m_hash.clear();
+    m_settings = m_snapshot.settings;
+    m_order = m_snapshot.order;
+    m_whitelist = m_snapshot.whitelist;
+    m_snapshot = Snapshot();
+    m_errors.clear();
+    m_inTransaction = false;
+}
+
+/**
+ * @brief If begin() was called without commit() or rollback().
+ */
+bool ShaderSettings::inTransaction() const {
+    return m_inTransaction;
+}
+
+/**
+ * @brief Why the changes of the current or last transaction failed.
+ */
+const QStringList &ShaderSettings::errors() const {
+    return m_errors;
+}
+
+/**
+ * @brief Check that parsing the buffer again finds the same settings, order and whitelist at the same places,
+ *        so the changes did not touch anything outside of their values.
+ */
+bool ShaderSettings::isConsistent() const {
+    auto equal = [](const Span &first, const Span &second) {
+        return first.start == second.start && first.length == second.length;
+    };
+    ShaderSettings parsed(m_text);
+    if (parsed.m_settings.size() != m_settings.size() || !equal(parsed.m_order, m_order) || !equal(parsed.m_whitelist, m_whitelist)) {
+        return false;
+    }
+    for (int i = 0; i < m_settings.size(); ++i) {
+        const Setting &setting = m_settings.at(i), &parsedSetting = parsed.m_settings.at(i);
+        if (setting.name != parsedSetting.name || setting.shader != parsedSetting.shader || setting.type != parsedSetting.type
+            || !equal(setting.value, parsedSetting.value) || !equal(setting.tooltip, parsedSetting.tooltip)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief End a change, commit it if it started its own transaction.
+ * @param ownTransaction : What begin() returned at the start of the change.
+ * @param errorCount     : Number of errors at the start of the change.
+ * @return False if the change failed.
+ */
+bool ShaderSettings::finish(bool ownTransaction, int errorCount) {
+    if (ownTransaction) {
+        return commit();
+    }
+    return m_errors.size() == errorCount;
+}
+
+/**
+ * @brief Record why a change failed, so commit() can revert the transaction.
+ * @param error
+ * @return Always false.
+ */
+bool ShaderSettings::fail(const QString &error) {
+    if (m_inTransaction) {
+        m_errors.append(error);
+    }
+    return false;
+}
+
+/**
+ * @brief Get the bytes of a span.
+ */
+QByteArray ShaderSettings::bytes(const Span &span) const {
+    if (!span.isValid()) {
+        return QByteArray();
+    }
+    return m_text.mid(span.start, span.length);
+}
+
+/**
+ * @brief Replace the bytes of a span, moving every span after it.
+ * @param span  : The span to replace, resized to the new value.
+ * @param value : The new bytes.
+ */
+void ShaderSettings::replace(Span &span, const QByteArray &value) {
+    const int start = span.start;
+    const int delta = value.size() - span.length;
+    m_text.replace(start, span.length, value);
+    m_hash.clear();
+    span.length = value.size();
+    if (!delta) {
+        return;
+    }
+    auto shift = [start, delta](Span &curSpan) {
+        if (curSpan.isValid() && curSpan.start > start) {
+            curSpan.start += delta;
+        }
+    };
+    for (Setting &curSetting : m_settings) {
+        shift(curSetting.value);
+        shift(curSetting.tooltip);
+    }
+    shift(m_order);
+    shift(m_whitelist);
+}
+
+/**
+ * @brief Find the values in the buffer.
+ *        Follows the layout of 1_settings.glsl.example, a shader is a "// Description:" and "// Source:" comment,
+ *        followed by a NAME_ENABLED define, followed by its settings, closed by the #endif matching the #if that
+ *        tests NAME_ENABLED, or the first unmatched #endif if there is no such #if.
+ */
+void ShaderSettings::parse() {
+    m_settings.clear();
+    m_index.clear();
+    m_order = Span();
+    m_whitelist = Span();
+
+    bool inOrder = false, foundOrder = false, foundSource = false, inShader = false, sectionOpened = false;
+    // Conditionals nested inside the current shader's section.
+    int depth = 0;
+    QByteArray curShader;
+    // Comments describing the current shader / setting, only kept as a range of the buffer.
+    Span shaderTooltip, curTooltip;
+    const int size = m_text.size();
+    int lineStart = 0;
+    while (lineStart < size) {
+        int lineEnd = m_text.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = size;
+        }
+        int start = lineStart, end = lineEnd;
+        lineStart = lineEnd + 1;
+        while (start < end && isSpace(m_text.at(start))) {
+            ++start;
+        }
+        while (end > start && isSpace(m_text.at(end - 1))) {
+            --end;
+        }
+        const QByteArray curLine = QByteArray::fromRawData(m_text.constData() + start, end - start);
+
+        // The shader order block, everything between the SHADER_ORDER line and the SHADERS); line.
+        if (!foundOrder) {
+            if (inOrder) {
+                if (curLine.startsWith("SHADERS);")) {
+                    m_order.length = start - m_order.start;
+                    inOrder = false;
+                    foundOrder = true;
+                }
+                continue;
+            }
+            if (curLine.startsWith("const") && curLine.contains("SHADER_ORDER")) {
+                m_order.start = qMin(lineStart, size);
+                inOrder = true;
+                continue;
+            }
+        }
+
+        if (!m_whitelist.isValid() && curLine.startsWith("//WHITELIST=\"")) {
+            int quote = curLine.lastIndexOf('"');
+            if (quote > 12) {
+                m_whitelist.start = start + 13;
+                m_whitelist.length = quote - 13;
+            }
+            continue;
+        }
+
+        if (!inShader) {
+            // Every shader starts with a description and source.
+            if (!foundSource) {
+                if (!shaderTooltip.isValid() && curLine.startsWith("// Description: ")) {
+                    shaderTooltip.start = start;
+                }
+                foundSource = curLine.startsWith("// Source: ");
+                if (foundSource && shaderTooltip.isValid()) {
+                    shaderTooltip.length = end - shaderTooltip.start;
+                }
+                continue;
+            }
+            if (curLine.startsWith("#define") && curLine.contains("_ENABLED")) {
+                int count = m_settings.size();
+                parseSetting(curLine, start, QByteArray());
+                if (m_settings.size() > count) {
+                    Setting &enabled = m_settings.last();
+                    if (enabled.name.endsWith("_ENABLED") && enabled.name.size() > 8 && isDigits(bytes(enabled.value))) {
+                        curShader = enabled.name.left(enabled.name.size() - 8);
+                        sectionOpened = false;
+                        depth = 0;
+                        enabled.shader = curShader;
+                        enabled.type = Enabled;
+                        enabled.tooltip = shaderTooltip;
+                        inShader = true;
+                    } else {
+                        if (m_index.value(enabled.name) == count) {
+                            m_index.remove(enabled.name);
+                        }
+                        m_settings.removeLast();
+                    }
+                }
+            }
+            continue;
+        }
+
+        // #if, #ifdef and #ifndef, the first one after the _ENABLED define opens the section, whatever it tests.
+        if (curLine.startsWith("#if")) {
+            if (!sectionOpened) {
+                sectionOpened = true;
+            } else {
+                ++depth;
+            }
+            continue;
+        }
+
+        // Reached the end of this shader's settings.
+        if (curLine.startsWith("#endif")) {
+            if (depth > 0) {
+                --depth;
+                continue;
+            }
+            inShader = false;
+            foundSource = false;
+            shaderTooltip = Span();
+            curTooltip = Span();
+            continue;
+        }
+
+        // Every comment since the previous setting describes the next setting.
+        if (curLine.startsWith("//")) {
+            if (!curTooltip.isValid()) {
+                curTooltip.start = start;
+            }
+            curTooltip.length = end - curTooltip.start;
+            continue;
+        }
+
+        if (curLine.startsWith("#define") || curLine.startsWith("uniform")) {
+            int count = m_settings.size();
+            parseSetting(curLine, start, curShader);
+            if (m_settings.size() > count) {
+                m_settings.last().tooltip = curTooltip;
+            }
+            curTooltip = Span();
+        }
+    }
+    // Unterminated order block, ignore it.
+    if (inOrder) {
+        m_order = Span();
+    }
+}
+
+/**
+ * @brief Parse a "#define NAME VALUE" or "uniform TYPE NAME = VALUE;" line.
+ * @param line   : The trimmed line.
+ * @param offset : Offset of the trimmed line in the buffer.
+ * @param shader : Name of the shader the setting belongs to.
+ */
+void ShaderSettings::parseSetting(const QByteArray &line, int offset, const QByteArray &shader) {
+    Setting setting;
+    setting.shader = shader;
+    const int size = line.size();
+    if (line.startsWith("#define")) {
+        int pos = 7;
+        if (pos >= size || !isSpace(line.at(pos))) {
+            return;
+        }
+        while (pos < size && isSpace(line.at(pos))) {
+            ++pos;
+        }
+        int nameStart = pos;
+        while (pos < size && isNameChar(line.at(pos))) {
+            ++pos;
+        }
+        if (pos == nameStart || pos >= size || !isSpace(line.at(pos))) {
+            return;
+        }
+        setting.name = line.mid(nameStart, pos - nameStart);
+        while (pos < size && isSpace(line.at(pos))) {
+            ++pos;
+        }
+        int valueStart = pos;
+        while (pos < size && !isSpace(line.at(pos))) {
+            ++pos;
+        }
+        if (pos == valueStart) {
+            return;
+        }
+        setting.type = Define;
+        setting.value.start = offset + valueStart;
+        setting.value.length = pos - valueStart;
+    } else {
+        if (size < 8 || !isSpace(line.at(7)) || !line.endsWith(';')) {
+            return;
+        }
+        int equals = line.indexOf('=');
+        if (equals < 0) {
+            return;
+        }
+        int nameEnd = equals;
+        while (nameEnd > 7 && isSpace(line.at(nameEnd - 1))) {
+            --nameEnd;
+        }
+        int nameStart = nameEnd;
+        while (nameStart > 7 && isNameChar(line.at(nameStart - 1))) {
+            --nameStart;
+        }
+        // There has to be a type between uniform and the name.
+        if (nameStart == nameEnd || nameEnd == equals || !isSpace(line.at(nameStart - 1)) || line.mid(7, nameStart - 7).trimmed().isEmpty()) {
+            return;
+        }
+        int valueStart = equals + 1;
+        if (valueStart >= size || !isSpace(line.at(valueStart))) {
+            return;
+        }
+        while (valueStart < size && isSpace(line.at(valueStart))) {
+            ++valueStart;
+        }
+        int valueEnd = size - 1;
+        while (valueEnd > valueStart && isSpace(line.at(valueEnd - 1))) {
+            --valueEnd;
+        }
+        if (valueEnd <= valueStart) {
+            return;
+        }
+        setting.name = line.mid(nameStart, nameEnd - nameStart);
+        setting.type = Uniform;
+        setting.value.start = offset + valueStart;
+        setting.value.length = valueEnd - valueStart;
+    }
+    if (!m_index.contains(setting.name)) {
+        m_index.insert(setting.name, m_settings.size());
+    }
+    m_settings.append(setting);
+}
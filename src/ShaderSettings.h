@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERSETTINGS_H
+#define SHADERSETTINGS_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Parsed 1_settings.glsl buffer.
+ *        Every editable value (shader enabled flags, shader settings, the shader order and the whitelist)
+ *        is stored as a byte range into the buffer, so values can be read and replaced without regexes.
+ *
+ *        Changes made between begin() and commit() are a transaction, if any of them is invalid,
+ *        commit() reverts all of them, so the buffer only has to be written once.
+ *        A change made outside of a transaction is a transaction of its own. Before a transaction is committed,
+ *        the buffer is parsed again, if that doesn't find the same settings at the same places, it is reverted.
+ */
+class ShaderSettings
+{
+public:
+    enum Type {
+        Enabled,
+        Define,
+        Uniform
+    };
+
+    struct Span {
+        int start = -1;
+        int length = 0;
+        bool isValid() const { return start >= 0; }
+    };
+
+    struct Setting {
+        QByteArray name;
+        QByteArray shader;
+        Type type = Define;
+        Span value;
+        Span tooltip;
+    };
+
+    ShaderSettings();
+    explicit ShaderSettings(const QByteArray &);
+
+    void setText(const QByteArray &);
+    const QByteArray &text() const;
+    QByteArray hash() const;
+
+    const QVector<Setting> &settings() const;
+    int indexOf(const QByteArray &) const;
+    QByteArray value(int) const;
+    QByteArray value(const QByteArray &) const;
+    QByteArray tooltip(int) const;
+    QByteArray tooltipView(int) const;
+    bool isValidValue(int, const QByteArray &) const;
+    QByteArray changedValue(int) const;
+    bool setValue(const QByteArray &, const QByteArray &);
+    bool setValues(const QVector<QPair<QByteArray, QByteArray>> &);
+    bool setEnabled(const QByteArray &, bool);
+
+    bool hasOrder() const;
+    QByteArrayList order() const;
+    bool setOrder(const QByteArrayList &);
+
+    bool hasWhitelist() const;
+    QByteArray whitelist() const;
+    bool setWhitelist(const QByteArray &);
+
+    bool begin();
+    bool commit();
+    void rollback();
+    bool inTransaction() const;
+    const QStringList &errors() const;
+    bool isConsistent() const;
+
+private:
+    struct Snapshot {
+        QByteArray text;
+        QVector<Setting> settings;
+        Span order;
+        Span whitelist;
+    };
+
+    bool fail(const QString &);
+    bool finish(bool, int);
+    void parse();
+    void parseSetting(const QByteArray &, int, const QByteArray &);
+    void replace(Span &, const QByteArray &);
+    QByteArray bytes(const Span &) const;
+
+    QByteArray m_text;
+    mutable QByteArray m_hash;
+    QVector<Setting> m_settings;
+    QHash<QByteArray, int> m_index;
+    Span m_order;
+    Span m_whitelist;
+    bool m_inTransaction = false;
+    Snapshot m_snapshot;
+    QStringList m_errors;
+};
+#endif // SHADERSETTINGS_H
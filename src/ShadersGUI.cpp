@@ -17,22 +17,39 @@
 
 #include "ShadersGUI.h"
 #include "./ui_ShadersGUI.h"
+#include "ProfileMigrator.h"
+#include "SettingItem.h"
+#include "WhitelistMatcher.h"
 //#include <QDebug>
+#include <QApplication>
+#include <QClipboard>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QLocalSocket>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QSignalBlocker>
 #include <QStandardPaths>
 #include <QTemporaryFile>
 
 /**
  * @brief Construct.
+ * @param settingsFile : INI file to use instead of the user's settings, used when replaying a session.
  */
-ShadersGUI::ShadersGUI(QWidget *parent)
+ShadersGUI::ShadersGUI(const QString &settingsFile, QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::ShadersGUI) {
     ui->setupUi(this);
+    // Both profile views share the same model.
+    ui->value_profileDropdown->setModel(&m_profilesModel);
+    ui->table_Profiles->setModel(&m_profilesModel);
     // Initialize settings.
-    m_settings = new QSettings("kevinlekiller", "kwin_effect_shaders");
+    if (settingsFile.isEmpty()) {
+        m_settings = new QSettings("kevinlekiller", "kwin_effect_shaders");
+    } else {
+        m_settings = new QSettings(settingsFile, QSettings::IniFormat);
+    }
 
     // Set values on UI.
     ui->value_AutoSave->setChecked(m_settings->value("AutoSave").toBool());
@@ -49,16 +66,19 @@ ShadersGUI::ShadersGUI(QWidget *parent)
     connect(ui->button_ShadersSave, &QDialogButtonBox::clicked, this, &ShadersGUI::slotShaderSave);
     connect(ui->button_SettingsSave, &QDialogButtonBox::clicked, this, &ShadersGUI::slotSettingsSave);
     connect(ui->button_WhiteListSave, &QDialogButtonBox::clicked, this, &ShadersGUI::slotWhiteListSave);
+    connect(ui->button_ShadersCopy, &QPushButton::clicked, this, &ShadersGUI::slotShaderSettingsCopy);
+    connect(ui->button_ShadersPaste, &QPushButton::clicked, this, &ShadersGUI::slotShaderSettingsPaste);
     connect(ui->button_MoveShaderUp, &QPushButton::clicked, this, &ShadersGUI::slotMoveShaderUp);
     connect(ui->button_MoveShaderDown, &QPushButton::clicked, this, &ShadersGUI::slotMoveShaderDown);
     connect(ui->button_ProfilesNew, &QPushButton::clicked, this, &ShadersGUI::slotProfileCreate);
     connect(ui->button_ProfilesCopy, &QPushButton::clicked, this, &ShadersGUI::slotProfileCopy);
     connect(ui->button_ProfilesRemove, &QPushButton::clicked, this, &ShadersGUI::slotProfileDelete);
-    connect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
-    connect(ui->table_Profiles, &QListWidget::itemClicked, this, &ShadersGUI::slotProfileMakeEditable);
+    connect(&m_profilesModel, &ProfileListModel::renameRequested, this, &ShadersGUI::slotProfileRenamed);
+    connect(&m_profilesModel, &ProfileListModel::profileRemoved, this, &ShadersGUI::slotProfileRemoved);
     connect(ui->value_ShaderOrder->model(), &QAbstractItemModel::rowsMoved, this, &ShadersGUI::slotUpdateShaderOrder);
     connect(ui->value_profileDropdown, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ShadersGUI::slotProfileChange);
     connect(ui->table_Shaders, &QTableWidget::cellClicked, this, &ShadersGUI::slotToggleShader);
+    connect(ui->value_ShaderFilter, &QLineEdit::textChanged, this, &ShadersGUI::slotFilterShaders);
     connect(ui->table_Shaders, &QTableWidget::itemChanged, this, &ShadersGUI::slotEditShaderSetting);
 }
 
@@ -72,17 +92,136 @@ ShadersGUI::~ShadersGUI() {
     delete ui;
 }
 
+/**
+ * @brief Set the name of the socket kwin_effect_shaders listens on.
+ * @param socketName
+ */
+void ShadersGUI::setSocketName(const QString &socketName) {
+    m_socketName = socketName;
+}
+
+/**
+ * @brief Record the operations of this session to a file, see SessionRecorder.
+ *        The settings and the profiles are part of the recording, so it replays from the same state on another machine.
+ * @param path : Path of the recording.
+ * @return False if the file could not be created.
+ */
+bool ShadersGUI::startRecording(const QString &path) {
+    SessionRecorder::Session state;
+    state.baseHash = m_baseSettings.hash();
+    state.profile = m_settings->value("ActiveProfile").toString();
+    state.autoSave = m_settings->value("AutoSave").toBool();
+    if (!m_baseSettings.text().isEmpty()) {
+        state.settings = ProfileDelta::fromSettings(m_baseSettings, shaderSettings()).serialize();
+    }
+    for (int row = 0; row < m_profilesModel.rowCount(); ++row) {
+        QString profile(m_profilesModel.profileAt(row));
+        QFile profileFile(QString(m_profilesPath).append(profile).append(".p"));
+        if (profileFile.open(QFile::ReadOnly)) {
+            state.profiles.append(qMakePair(profile, profileFile.readAll()));
+        }
+    }
+    return m_recorder.start(path, state);
+}
+
+/**
+ * @brief Perform a recorded operation the way the user did, through the same slots.
+ * @param operation
+ * @return False if the operation could not be performed, the session diverged from the recording.
+ */
+bool ShadersGUI::replay(const SessionRecorder::Operation &operation) {
+    QString name(QString::fromUtf8(operation.name));
+    switch (operation.type) {
+        case SessionRecorder::Toggle: {
+            int row = findSettingRow(QString("SHADER_").append(name));
+            if (row < 0) {
+                return false;
+            }
+            // Only click if the shader isn't already in the recorded state.
+            QString state(operation.value == "1" ? "On" : "Off");
+            if (QString::compare(ui->table_Shaders->item(row, 1)->text(), state) == 0) {
+                return false;
+            }
+            slotToggleShader(row, 1);
+            row = findSettingRow(QString("SHADER_").append(name));
+            return row >= 0 && QString::compare(ui->table_Shaders->item(row, 1)->text(), state) == 0;
+        }
+        case SessionRecorder::Edit: {
+            int row = findSettingRow(name);
+            if (row < 0) {
+                return false;
+            }
+            // Emits itemChanged, like editing the cell.
+            ui->table_Shaders->item(row, 1)->setText(QString::fromUtf8(operation.value));
+            return m_shaderSettings.value(operation.name) == operation.value;
+        }
+        case SessionRecorder::Profile: {
+            int index = m_profilesModel.indexOf(name);
+            if (index < 0) {
+                return false;
+            }
+            ui->value_profileDropdown->setCurrentIndex(index);
+            return QString::compare(m_settings->value("ActiveProfile").toString(), name) == 0;
+        }
+        case SessionRecorder::Order: {
+            QStringList order(QString::fromUtf8(operation.value).split(','));
+            ui->value_ShaderOrder->clear();
+            ui->value_ShaderOrder->addItems(order);
+            slotUpdateShaderOrder();
+            return shaderSettings().order() == operation.value.split(',');
+        }
+        case SessionRecorder::Whitelist:
+            ui->value_Whitelist->setPlainText(QString::fromUtf8(operation.value));
+            slotWhiteListSave();
+            return shaderSettings().whitelist() == operation.value;
+        case SessionRecorder::Paste:
+            return pasteSettings(operation.value).isEmpty();
+        case SessionRecorder::Save:
+            slotShaderSave();
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Find the row of a setting or shader in the shader table.
+ * @param settingName : Name of the setting, SHADER_ followed by the name for a shader.
+ * @return The row, -1 if the setting is not shown.
+ */
+int ShadersGUI::findSettingRow(const QString &settingName) const {
+    for (int row = 0; row < ui->table_Shaders->rowCount(); ++row) {
+        QTableWidgetItem *nameItem = ui->table_Shaders->item(row, 0);
+        if (nameItem && QString::compare(nameItem->text(), settingName) == 0) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief The parsed shader setting buffer, the slots change the buffer through it.
+ *        Only parsed again if the buffer was replaced some other way, like a profile change or a reverted save.
+ */
+ShaderSettings &ShadersGUI::shaderSettings() {
+    if (m_shaderSettings.text() != m_shadersText) {
+        m_shaderSettings.setText(m_shadersText);
+    }
+    return m_shaderSettings;
+}
+
 /**
  * @brief If we changed the shader settings file, tell kwin_effect_shaders.
  */
 void ShadersGUI::connectToSocket() {
     QLocalSocket socket;
-    socket.setServerName("kwin_effect_shaders");
+    socket.setServerName(m_socketName);
     socket.connectToServer();
     socket.waitForConnected(250);
     // If autosave is enabled and the operation fails, revert back to previous values.
     if ((!socket.waitForReadyRead(250) || !socket.readAll().operator==("success\n")) && m_settings->value("AutoSave").toBool()) {
         m_shadersText.swap(m_prevShadersText);
+        // Every change of the rejected save is reverted at once.
+        writeShadersText();
         parseShadersText();
     }
     socket.close();
@@ -127,6 +266,15 @@ void ShadersGUI::processShaderPath(QString shaderPath) {
     m_shaderSettingsPath = m_shaderPath;
     m_shaderSettingsPath.append(m_shaderSettingsName);
 
+    // Profiles are stored as the differences from the example file.
+    QFile exampleFile(QString(m_shaderSettingsPath).append(".example"));
+    m_baseSettings = ShaderSettings();
+    if (exampleFile.open(QFile::ReadOnly)) {
+        m_baseSettings.setText(exampleFile.readAll());
+        // Hashed once here, profile saves and migrations reuse it.
+        m_baseSettings.hash();
+    }
+
     // Create Profiles dir.
     shadersDir.mkdir("p");
     m_profilesPath = shadersDir.absolutePath();
@@ -138,53 +286,74 @@ void ShadersGUI::processShaderPath(QString shaderPath) {
  * @brief Adds the profiles to the UI.
  */
 void ShadersGUI::setProfilesToUI() {
-    QDir profilesDir(m_profilesPath);
-
-    // Create iterator of .p files in profiles dir.
-    profilesDir.setNameFilters(QStringList() << "*.p");
-    profilesDir.setSorting(QDir::Name);
-    QStringList profiles(profilesDir.entryList());
-
-    // Reset UI values.
-    ui->value_profileDropdown->clear();
-    ui->table_Profiles->clear();
+    QString activeProfile = m_settings->value("ActiveProfile").toString();
+    {
+        // Don't activate whichever profile the dropdown lands on while loading.
+        const QSignalBlocker blocker(ui->value_profileDropdown);
+        m_profilesModel.setProfilesPath(m_profilesPath);
+    }
+    migrateProfiles();
 
     // No profile exists, copy 1_settings.glsl.example to X.p
-    if (profiles.isEmpty()) {
+    if (!m_profilesModel.rowCount()) {
         slotProfileCreate();
         // Set profile as current profile.
-        setProfileActive(ui->value_profileDropdown->itemText(0));
-        ui->value_profileDropdown->setCurrentIndex(0);
+        setProfileActive(m_profilesModel.profileAt(0));
         return;
     }
-    bool foundActiveProfile = false;
-    QString activeProfile = m_settings->value("ActiveProfile").toString();
-    // Iterate .p files.
-    for (auto &curProfile : profiles) {
-        curProfile.chop(2);
-        // Set profiles to UI.
-        ui->value_profileDropdown->addItem(curProfile);
-        ui->table_Profiles->addItem(curProfile);
-        if (QString::compare(activeProfile, curProfile) == 0) {
-            foundActiveProfile = true;
+    if (!m_profilesModel.contains(activeProfile)) {
+        activeProfile = m_profilesModel.profileAt(0);
+    }
+    setProfileActive(activeProfile);
+}
+
+/**
+ * @brief If the shader pack updated the example file, rebase the profiles onto it.
+ */
+void ShadersGUI::migrateProfiles() {
+    ui->value_ProfilesMigrated->setText("");
+    ui->value_ProfilesMigrated->setToolTip("");
+    if (m_baseSettings.text().isEmpty() || !m_profilesModel.rowCount()) {
+        return;
+    }
+    ProfileMigrator migrator(m_baseSettings, m_profilesPath);
+    // Older versions linked the settings file to the active profile, don't let it show the rewritten profile.
+    if (!migrator.materializeSettingsFile(m_shaderSettingsPath)) {
+        return;
+    }
+    m_profilesModel.setWatching(false);
+    QVector<ProfileMigrator::Report> reports(migrator.migrate(m_profilesModel.profiles(), false));
+    m_profilesModel.setWatching(true);
+    int migrated = 0, failed = 0;
+    for (const ProfileMigrator::Report &report : reports) {
+        if (report.failed) {
+            failed++;
+        } else if (report.migrated) {
+            migrated++;
         }
     }
-    sortProfiles();
-    if (!foundActiveProfile) {
-        setProfileActive(ui->value_profileDropdown->itemText(0));
-        ui->value_profileDropdown->setCurrentIndex(0);
-    } else {
-        setProfileActive(activeProfile);
+    if (!migrated && !failed) {
+        return;
     }
+    QString status(QString("%1 of %2 profiles updated").arg(migrated).arg(reports.size()));
+    if (failed) {
+        status.append(QString(", %1 failed").arg(failed));
+    }
+    ui->value_ProfilesMigrated->setText(status.append("."));
+    ui->value_ProfilesMigrated->setToolTip(ProfileMigrator::summary(reports));
 }
 
 /**
  * @brief User clicked button to create a new profile.
  */
 void ShadersGUI::slotProfileCreate() {
-    QString examplePath(m_shaderSettingsPath);
-    examplePath.append(".example");
-    createProfileFile(examplePath);
+    if (m_baseSettings.text().isEmpty()) {
+        return;
+    }
+    // A new profile has no differences from the example file.
+    ProfileDelta delta;
+    delta.baseHash = m_baseSettings.hash();
+    createProfileFile(delta.serialize());
 }
 
 /**
@@ -192,81 +361,137 @@ void ShadersGUI::slotProfileCreate() {
  */
 void ShadersGUI::slotProfileCopy() {
     // No item selected.
-    if (ui->table_Profiles->currentRow() < 0) {
-        return;
-    }
-    QListWidgetItem *currentItem(ui->table_Profiles->currentItem());
-    QString profileName(currentItem->text().trimmed());
+    QString profileName(m_profilesModel.profileAt(ui->table_Profiles->currentIndex().row()));
     if (profileName.isEmpty()) {
         return;
     }
     QString profilePath(m_profilesPath);
     profilePath.append(profileName).append(".p");
-    createProfileFile(profilePath);
+    if (!QFile::exists(profilePath)) {
+        return;
+    }
+    createProfileFile(readProfile(profileName).serialize());
 }
 
 /**
- * @brief Creates a new profile based on a existing profile or the example profile.
- * @param originalFilePath : Path to the original file that will be copied to make the new profile.
+ * @brief Creates a new profile file with a unique name.
+ * @param profileData : Contents of the new profile.
  */
-void ShadersGUI::createProfileFile(QString originalFilePath) {
+void ShadersGUI::createProfileFile(const QByteArray &profileData) {
     // Create file with unique name.
-    QTemporaryFile newProfile;
-    newProfile.setFileTemplate("ProfileXXXXXX.p");
+    QTemporaryFile newProfile(QString(m_profilesPath).append("ProfileXXXXXX.p"));
     newProfile.setAutoRemove(false);
     // This creates the file.
-    newProfile.open();
-    newProfile.close();
-    // Delete the file, or it will fail when we try to copy.
-    QFile::remove(newProfile.fileName());
-    QFile oldFile(originalFilePath);
-    // Copy example file to new profile.
-    if (!oldFile.copy(newProfile.fileName())) {
+    if (!newProfile.open()) {
+        return;
+    }
+    if (newProfile.write(profileData) != profileData.size()) {
+        newProfile.remove();
         return;
     }
+    newProfile.close();
     // Get the filename without path.
     QFileInfo fInfo(newProfile.fileName());
     QString newProfileName(fInfo.fileName());
-    QString newProfilePath(m_profilesPath);
-    newProfilePath.append(newProfileName);
-    // Move the file to the profiles dir.
-    QFile::rename(newProfile.fileName(), newProfilePath);
     // Remove .p extension.
     newProfileName.chop(2);
     // Add profile to UI.
-    ui->value_profileDropdown->addItem(newProfileName);
-    ui->table_Profiles->addItem(newProfileName);
-    sortProfiles();
+    m_profilesModel.addProfile(newProfileName);
 }
 
 /**
- * @brief User clicked button to delete selected profile.
+ * @brief Read a profile file, profiles from older versions (full copies of the settings file) are
+ *        converted to the delta format and rewritten.
+ * @param profile : Name of the profile.
+ * @return The profile.
  */
-void ShadersGUI::slotProfileDelete() {
-    // No item selected.
-    if (ui->table_Profiles->currentRow() < 0) {
+ProfileDelta ShadersGUI::readProfile(const QString &profile) {
+    ProfileDelta delta;
+    delta.baseHash = m_baseSettings.hash();
+    QString profilePath(m_profilesPath);
+    profilePath.append(profile).append(".p");
+    QFile profileFile(profilePath);
+    if (!profileFile.open(QFile::ReadOnly)) {
+        return delta;
+    }
+    QByteArray profileData(profileFile.readAll());
+    profileFile.close();
+    if (delta.parse(profileData)) {
+        return delta;
+    }
+    delta = ProfileDelta::fromSettings(m_baseSettings, ShaderSettings(profileData));
+    writeProfile(profile, delta.serialize());
+    return delta;
+}
+
+/**
+ * @brief Replace the contents of a profile file.
+ * @param profile     : Name of the profile.
+ * @param profileData : Contents of the profile.
+ */
+bool ShadersGUI::writeProfile(const QString &profile, const QByteArray &profileData) {
+    QString profilePath(m_profilesPath);
+    profilePath.append(profile).append(".p");
+    // The profile already exists, the model doesn't have to rescan the directory for the temporary file.
+    m_profilesModel.setWatching(false);
+    QSaveFile profileFile(profilePath);
+    bool written = profileFile.open(QFile::WriteOnly);
+    if (written) {
+        profileFile.write(profileData);
+        written = profileFile.commit();
+    }
+    m_profilesModel.setWatching(true);
+    return written;
+}
+
+/**
+ * @brief Store the differences between the current settings and the example file in the active profile.
+ */
+void ShadersGUI::saveActiveProfile() {
+    QString profile(m_settings->value("ActiveProfile").toString());
+    if (profile.isEmpty() || !m_profilesModel.contains(profile) || m_baseSettings.text().isEmpty()) {
         return;
     }
+    writeProfile(profile, ProfileDelta::fromSettings(m_baseSettings, shaderSettings()).serialize());
+}
+
+/**
+ * @brief User clicked button to delete selected profile.
+ */
+void ShadersGUI::slotProfileDelete() {
     // Don't remove last profile.
-    if (ui->table_Profiles->count() <= 1) {
+    if (m_profilesModel.rowCount() <= 1) {
         return;
     }
-    QListWidgetItem *currentItem(ui->table_Profiles->currentItem());
-    QString profileName(currentItem->text().trimmed());
+    // No item selected.
+    QString profileName(m_profilesModel.profileAt(ui->table_Profiles->currentIndex().row()));
     if (profileName.isEmpty()) {
         return;
     }
-    // Remove profile from UI.
-    ui->table_Profiles->removeItemWidget(currentItem);
-    int comboIndex = ui->value_profileDropdown->findText(profileName);
-    if (comboIndex > -1) {
-        ui->value_profileDropdown->removeItem(comboIndex);
-    }
     // Delete the actual file.
     QString profilePath(m_profilesPath);
     profilePath.append(profileName).append(".p");
-    QFile::remove(profilePath);
-    setProfilesToUI();
+    if (!QFile::remove(profilePath)) {
+        return;
+    }
+    // Remove profile from UI.
+    m_profilesModel.removeProfile(profileName);
+    slotProfileRemoved(profileName);
+}
+
+/**
+ * @brief A profile was removed, if it was the active profile, activate another one.
+ * @param profileName : Name of the removed profile.
+ */
+void ShadersGUI::slotProfileRemoved(const QString &profileName) {
+    if (QString::compare(m_settings->value("ActiveProfile").toString(), profileName) != 0) {
+        return;
+    }
+    if (!m_profilesModel.rowCount()) {
+        setProfilesToUI();
+        return;
+    }
+    setProfileActive(m_profilesModel.profileAt(0));
 }
 
 /**
@@ -277,23 +502,38 @@ void ShadersGUI::setProfileActive(QString profile) {
     QString profilePath(m_profilesPath);
     profilePath.append(profile).append(".p");
     QFile profileFile(profilePath);
-    if (!profileFile.exists()) {
+    if (!profileFile.exists() || m_baseSettings.text().isEmpty()) {
         return;
     }
+    // Apply the profile's differences on top of the example file.
+    ShaderSettings settings(readProfile(profile).apply(m_baseSettings));
+    QByteArray shadersText(settings.text());
     unWatchSettingsFile();
-    QFile::remove(m_shaderSettingsPath);
-    QFile::link(profilePath, m_shaderSettingsPath);
-    QFile settingsFile(m_shaderSettingsPath);
-    if (!settingsFile.exists() || !settingsFile.open(QFile::ReadOnly)) {
+    // Older versions linked the profile to the settings file, don't write through the link.
+    if (QFileInfo(m_shaderSettingsPath).isSymLink()) {
+        QFile::remove(m_shaderSettingsPath);
+    }
+    // Replaced in one rename, kwin_effect_shaders never sees the file missing or half written.
+    QSaveFile settingsFile(m_shaderSettingsPath);
+    if (!settingsFile.open(QFile::WriteOnly)) {
+        watchSettingsFile();
+        return;
+    }
+    settingsFile.write(shadersText);
+    if (!settingsFile.commit()) {
+        watchSettingsFile();
         return;
     }
     m_settings->setValue("ActiveProfile", profile);
     m_settings->sync();
     m_prevShadersText.clear();
     m_prevShadersText.append(m_shadersText);
-    m_shadersText = settingsFile.readAll();
+    m_shadersText.swap(shadersText);
+    // Already parsed while applying the profile.
+    m_shaderSettings = settings;
+    writeWhitelistMatcher();
     watchSettingsFile();
-    ui->value_profileDropdown->setCurrentIndex(ui->value_profileDropdown->findText(profile));
+    ui->value_profileDropdown->setCurrentIndex(m_profilesModel.indexOf(profile));
     parseShadersText();
 }
 
@@ -302,71 +542,39 @@ void ShadersGUI::setProfileActive(QString profile) {
  * @param int index
  */
 void ShadersGUI::slotProfileChange(int index) {
-    QString profileName(ui->value_profileDropdown->itemText(index));
-    if (profileName.isEmpty()) {
+    QString profileName(m_profilesModel.profileAt(index));
+    // The index also changes when profiles are inserted or removed above the active one.
+    if (profileName.isEmpty() || QString::compare(profileName, m_settings->value("ActiveProfile").toString()) == 0) {
         return;
     }
+    m_recorder.record(SessionRecorder::Profile, profileName.toUtf8());
     setProfileActive(profileName);
 }
 
-/**
- * @brief If any changes are made to the profiles, re-sort them.
- */
-void ShadersGUI::sortProfiles() {
-    ui->table_Profiles->sortItems();
-    ui->value_profileDropdown->model()->sort(0, Qt::AscendingOrder);
-}
-
 /**
  * @brief User renamed the profile.
- * @param item
+ * @param oldProfileName : Current name of the profile.
+ * @param newProfileName : Name the user typed.
  */
-void ShadersGUI::slotProfileRenamed(QListWidgetItem *item) {
-    QString oldProfileName = m_oldProfileName;
-    m_oldProfileName = item->text();
-    if (item->text().isEmpty() || QString::compare(item->text(), oldProfileName) == 0 || ui->value_profileDropdown->findText(item->text()) >= 0) {
-        disconnect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
-        item->setText(oldProfileName);
-        connect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
+void ShadersGUI::slotProfileRenamed(const QString &oldProfileName, const QString &newProfileName) {
+    QString newProfilePath(m_profilesPath);
+    newProfilePath.append(newProfileName).append(".p");
+    if (QFile::exists(newProfilePath)) {
         return;
     }
-    QString newProfilePath(m_shaderPath);
-    newProfilePath.append("p/").append(item->text()).append(".p");
-    QFile newProfileFile(newProfilePath);
-    if (newProfileFile.exists()) {
-        disconnect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
-        item->setText(oldProfileName);
-        connect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
+    QString oldProfilePath(m_profilesPath);
+    oldProfilePath.append(oldProfileName).append(".p");
+    if (!QFile::rename(oldProfilePath, newProfilePath)) {
         return;
     }
-    QString oldProfilePath(m_shaderPath);
-    oldProfilePath.append("p/").append(oldProfileName).append(".p");
-    QFile oldProfileFile(oldProfilePath);
-    if (!oldProfileFile.copy(newProfilePath)) {
-        return;
+    {
+        // The dropdown index moves with the profile, that's not a profile change.
+        const QSignalBlocker blocker(ui->value_profileDropdown);
+        m_profilesModel.renameProfile(oldProfileName, newProfileName);
     }
-    QFile::remove(oldProfilePath);
     if (QString::compare(m_settings->value("ActiveProfile").toString(), oldProfileName) == 0) {
-        setProfileActive(item->text());
-        ui->value_profileDropdown->setItemText(ui->value_profileDropdown->findText(oldProfileName), item->text());
-        sortProfiles();
-        ui->value_profileDropdown->setCurrentIndex(ui->value_profileDropdown->findText(item->text()));
-        return;
+        setProfileActive(newProfileName);
     }
-    ui->value_profileDropdown->setItemText(ui->value_profileDropdown->findText(oldProfileName), item->text());
-    sortProfiles();
-}
-
-/**
- * @brief QListWidget is non editable, so set the item to be editable any time the user clicks it.
- *        Stores the current profile name in case the user is going to edit that profile name.
- * @param item
- */
-void ShadersGUI::slotProfileMakeEditable(QListWidgetItem *item) {
-    disconnect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
-    item->setFlags(item->flags() | Qt::ItemIsEditable);
-    m_oldProfileName = item->text();
-    connect(ui->table_Profiles, &QListWidget::itemChanged, this, &ShadersGUI::slotProfileRenamed);
 }
 
 /**
@@ -423,15 +631,99 @@ void ShadersGUI::updateShadersText(QByteArray shadersText) {
  * @brief User requested saving the shader settings.
  */
 void ShadersGUI::slotShaderSave() {
+    // With autosave the save buttons are hidden, the save is part of the operation that triggered it.
+    if (!m_settings->value("AutoSave").toBool()) {
+        m_recorder.record(SessionRecorder::Save);
+    }
+    if (!writeShadersText()) {
+        return;
+    }
+    connectToSocket();
+}
+
+/**
+ * @brief Write the shader setting buffer to the settings file and the active profile.
+ * @return False if the settings file could not be written.
+ */
+bool ShadersGUI::writeShadersText() {
     unWatchSettingsFile();
     QFile settingsFile(m_shaderSettingsPath);
     if (!settingsFile.exists() || !settingsFile.open(QFile::WriteOnly | QFile::Truncate)) {
-        return;
+        return false;
     }
     settingsFile.write(m_shadersText);
     settingsFile.close();
+    writeWhitelistMatcher();
+    saveActiveProfile();
     watchSettingsFile();
-    connectToSocket();
+    return true;
+}
+
+/**
+ * @brief Write the compiled whitelist next to the settings file, so kwin_effect_shaders doesn't have to parse it,
+ *        the file is removed if the whitelist is empty, see WhitelistMatcher.
+ */
+void ShadersGUI::writeWhitelistMatcher() {
+    QString matcherPath(m_shaderSettingsPath);
+    matcherPath.append(".whitelist");
+    WhitelistMatcher matcher(QString::fromUtf8(shaderSettings().whitelist()));
+    if (matcher.isEmpty()) {
+        QFile::remove(matcherPath);
+        return;
+    }
+    QSaveFile matcherFile(matcherPath);
+    if (!matcherFile.open(QFile::WriteOnly)) {
+        return;
+    }
+    matcherFile.write(matcher.serialize());
+    matcherFile.commit();
+}
+
+/**
+ * @brief User requested copying the settings that differ from the example file, as NAME=VALUE lines.
+ */
+void ShadersGUI::slotShaderSettingsCopy() {
+    if (m_baseSettings.text().isEmpty()) {
+        return;
+    }
+    ProfileDelta delta(ProfileDelta::fromSettings(m_baseSettings, shaderSettings()));
+    QApplication::clipboard()->setText(QString::fromUtf8(delta.serializeBlock()));
+}
+
+/**
+ * @brief User requested pasting NAME=VALUE lines, they are applied all at once, or not at all if one is invalid.
+ */
+void ShadersGUI::slotShaderSettingsPaste() {
+    QByteArray block(QApplication::clipboard()->text().toUtf8());
+    m_recorder.record(SessionRecorder::Paste, QByteArray(), block);
+    QStringList errors(pasteSettings(block));
+    if (!errors.isEmpty()) {
+        QMessageBox::warning(this, "Paste Settings", errors.join("\n"));
+    }
+}
+
+/**
+ * @brief Apply NAME=VALUE lines to the shader settings.
+ * @param block : The lines.
+ * @return Why the lines were not applied, empty if they were.
+ */
+QStringList ShadersGUI::pasteSettings(const QByteArray &block) {
+    ProfileDelta delta;
+    // One unreadable line rejects the whole block, like an invalid value does.
+    QStringList errors(delta.parseBlock(block));
+    if (!errors.isEmpty()) {
+        return errors;
+    }
+    if (delta.values.isEmpty() && !delta.hasOrder && !delta.hasWhitelist) {
+        return QStringList() << "There are no NAME=VALUE lines to paste.";
+    }
+    ShaderSettings &settings = shaderSettings();
+    if (!delta.applyTo(settings)) {
+        return settings.errors();
+    }
+    updateShadersText(settings.text());
+    parseShadersText();
+    return QStringList();
 }
 
 /**
@@ -474,15 +766,23 @@ void ShadersGUI::slotSettingsSave() {
  */
 void ShadersGUI::slotWhiteListSave() {
     m_settings->sync();
-    QString whiteList(ui->value_Whitelist->toPlainText().trimmed().replace(QString("\n"), QString(" ")).replace(QString("\t"), QString(" ")));
+    // Show the user the list the way it's stored.
+    QString whiteList(WhitelistMatcher::normalize(ui->value_Whitelist->toPlainText()));
+    if (QString::compare(ui->value_Whitelist->toPlainText(), whiteList) != 0) {
+        ui->value_Whitelist->setPlainText(whiteList);
+    }
     m_settings->setValue("Whitelist", whiteList);
     m_settings->sync();
-    QString whiteListReplacement("//WHITELIST=\"");
-    whiteListReplacement.append(whiteList).append("\"");
-    QRegularExpression replaceRegex("^//WHITELIST=\".*?\"", QRegularExpression::MultilineOption);
-    QString shadersText(m_shadersText);
-    shadersText.replace(replaceRegex, whiteListReplacement);
-    updateShadersText(shadersText);
+    ShaderSettings &settings = shaderSettings();
+    if (!settings.setWhitelist(whiteList.toUtf8())) {
+        return;
+    }
+    // Saving the list unchanged doesn't write the file.
+    if (settings.text() == m_shadersText) {
+        return;
+    }
+    m_recorder.record(SessionRecorder::Whitelist, QByteArray(), settings.whitelist());
+    updateShadersText(settings.text());
 }
 
 /**
@@ -503,14 +803,13 @@ void ShadersGUI::slotToggleShader(int row, int column) {
         return;
     }
 
-    QString shadersText = m_shadersText;
-    QString regex = "^#define\\s+";
+    ShaderSettings &settings = shaderSettings();
     settingName.remove(0, 7);
-    regex.append(settingName).append("_ENABLED\\s+\\d+");
-    QRegularExpression replaceRegex(regex, QRegularExpression::MultilineOption);
-    settingName.prepend("#define ").append("_ENABLED ").append(on == 0 ? "0" : "1");
-    shadersText.replace(replaceRegex, settingName);
-    updateShadersText(shadersText);
+    m_recorder.record(SessionRecorder::Toggle, settingName.toUtf8(), on != 0 ? "1" : "0");
+    if (!settings.setEnabled(settingName.toUtf8(), on != 0)) {
+        return;
+    }
+    updateShadersText(settings.text());
     parseShadersText();
 }
 
@@ -534,31 +833,14 @@ void ShadersGUI::slotEditShaderSetting(QTableWidgetItem *item) {
         return;
     }
 
-    QString replacement, regex, verificationRegex;
-    if (settingValue.startsWith("vec3(")) {
-        verificationRegex = "^vec3\\((-?\\d+\\.\\d+\\,\\s*){2}-?\\d+\\.\\d+\\)$";
-        replacement.append("uniform vec3 ").append(settingName).append(" = ").append(settingValue).append(";");
-        regex.append("^uniform\\s+vec3\\s+").append(settingName).append("\\s+=\\s+.+?").append(";");
-    } else if (settingValue.startsWith("vec2(")) {
-        verificationRegex = "^vec2\\(-?\\d+\\.\\d+\\,\\s*-?\\d+\\.\\d+\\)$";
-        replacement.append("uniform vec2 ").append(settingName).append(" = ").append(settingValue).append(";");
-        regex.append("^uniform\\s+vec2\\s+").append(settingName).append("\\s+=\\s+.+?").append(";");
-    } else {
-        verificationRegex = "^(-?\\d+|-?\\d+\\.\\d+)$";
-        replacement.append("#define ").append(settingName).append(" ").append(settingValue);
-        regex.append("^#define\\s+").append(settingName).append("\\s+[\\d.-]+");
-    }
-    // Validate input.
-    QRegularExpression rev(verificationRegex);
-    QRegularExpressionMatch matches = rev.match(settingValue);
-    if (!matches.hasMatch()) {
+    m_recorder.record(SessionRecorder::Edit, settingName.toUtf8(), settingValue.toUtf8());
+    // Validates the input against the current value's type.
+    ShaderSettings &settings = shaderSettings();
+    if (!settings.setValue(settingName.toUtf8(), settingValue.toUtf8())) {
         parseShadersText();
         return;
     }
-    QString shadersText = QString(m_shadersText);
-    QRegularExpression replaceRegex(regex, QRegularExpression::MultilineOption);
-    shadersText.replace(replaceRegex, replacement);
-    updateShadersText(shadersText);
+    updateShadersText(settings.text());
     parseShadersText();
 }
 
@@ -569,177 +851,126 @@ void ShadersGUI::slotUpdateShaderOrder() {
     if (!ui->value_ShaderOrder->count()) {
         return;
     }
-    QString order = "const int SHADER_ORDER[SHADERS+1] = int[] ( // Don't change this line.\n\n";
+    QByteArrayList order;
     for (int i = 0; i < ui->value_ShaderOrder->count(); ++i) {
-        order.append("    SHADER_").append(ui->value_ShaderOrder->item(i)->text()).append(",\n");
+        order.append(ui->value_ShaderOrder->item(i)->text().toUtf8());
     }
-    order.append("\nSHADERS); //");
-    QRegularExpression orderRegex("^const\\s+int\\s+SHADER_ORDER.+?^SHADERS\\);\\s+//", QRegularExpression::DotMatchesEverythingOption | QRegularExpression::MultilineOption);
-    QString shadersText = QString(m_shadersText);
-    shadersText = shadersText.replace(orderRegex, order);
-    updateShadersText(shadersText);
+    m_recorder.record(SessionRecorder::Order, QByteArray(), order.join(','));
+    ShaderSettings &settings = shaderSettings();
+    if (!settings.setOrder(order)) {
+        return;
+    }
+    updateShadersText(settings.text());
 }
 
 /**
  * @brief Process the shader settings, set variables to the UI.
  */
 void ShadersGUI::parseShadersText() {
-    QStringList lines = QString(m_shadersText).split("\n");
-    if (lines.empty()) {
-        return;
-    }
-    int curTableRow = 0;
-    ui->table_Shaders->clearContents();
-    ui->table_Shaders->setRowCount(curTableRow);
-
-    QRegularExpression enabledRegex("^#define\\s+([A-Z0-9_]+)_ENABLED\\s+(\\d)");
-    QRegularExpression setting1Regex("^#define\\s+([A-Z0-9_]+)\\s+(\\S+)");
-    QRegularExpression setting2Regex("^uniform\\s+.+?\\s+([A-Z0-9_]+)\\s+=\\s+(.+?);\\s*$");
+    const QVector<ShaderSettings::Setting> &settings = shaderSettings().settings();
 
     disconnect(ui->table_Shaders, &QTableWidget::itemChanged, this, &ShadersGUI::slotEditShaderSetting);
-    bool foundOrder = false, foundDefine = false, foundDesc = false, foundSource = false, foundWhitelist = false, curShaderEnabled = false;
-    QStringList shaderOrder;
-    QString curShader, enabledShaders, curTooltip, shaderTooltip;
-    for (int i = 0; i < lines.size(); ++i) {
-        QString curLine = lines.at(i).trimmed();
-
-        // Set the shader order on the UI.
-        if (!foundOrder) {
-            if (curLine.startsWith("SHADERS);")) {
-                foundOrder = true;
-                continue;
-            }
-            if (curLine.startsWith("SHADER_")) {
-                curLine.remove(0, 7);
-                if (curLine.endsWith(",")) {
-                    curLine.chop(1);
-                }
-                shaderOrder.append(curLine);
-                continue;
-            }
-        }
-
-        // Find the whitelist.
-        if (!foundWhitelist && curLine.startsWith("//WHITELIST=\"")) {
-            foundWhitelist = true;
-            QString whiteList = curLine;
-            whiteList.remove(0, 13).chop(1);
-            ui->value_Whitelist->setPlainText(whiteList);
-            slotWhiteListSave();
-            continue;
-        }
-
-        // Get tooltip for the shader.
-        if (!foundSource) {
-            if (curLine.startsWith("// Source: ")) {
-                foundSource = true;
-            } else if (!foundDesc && curLine.startsWith("// Description: ")) {
-                foundDesc = true;
-            }
-            if (!foundDesc) {
-                continue;
-            }
-            // Remove the leading //
-            curLine = curLine.remove(0, 2).trimmed();
-            if (curLine.startsWith("Description: ")) {
-                shaderTooltip.append("<p>").append(curLine);
-            } else if (curLine.startsWith("Source: ")) {
-                shaderTooltip.append("</p><p>").append(curLine).append("</p>");
-            } else if (curLine.startsWith("License: ")) {
-                shaderTooltip.append("<p>").append(curLine).append("</p>");
-            } else {
-                shaderTooltip.append(" ").append(curLine);
+    ui->table_Shaders->clearContents();
+    ui->table_Shaders->setRowCount(0);
+    m_settingsIndex.beginUpdate();
+
+    // Every shader gets a row, settings only if their shader is enabled.
+    QVector<int> rows;
+    QStringList enabledShaders;
+    bool curShaderEnabled = false;
+    for (int i = 0; i < settings.size(); ++i) {
+        const ShaderSettings::Setting &setting = settings.at(i);
+        // Settings of disabled shaders are indexed too, so toggling a shader doesn't change the index.
+        if (setting.type == ShaderSettings::Enabled) {
+            QString shader(QString::fromUtf8(setting.shader));
+            m_settingsIndex.update(QString("SHADER_").append(shader), shader, m_shaderSettings.tooltipView(i));
+            curShaderEnabled = m_shaderSettings.value(i).toInt() == 1;
+            if (curShaderEnabled) {
+                enabledShaders.append(shader);
             }
+            rows.append(i);
             continue;
         }
-
-        // Find the start of shader's settings.
-        if (!foundDefine) {
-            QRegularExpressionMatch matches = enabledRegex.match(curLine);
-            if (matches.hasMatch()) {
-               curShader = matches.captured(1).prepend("SHADER_");
-               curShaderEnabled = matches.captured(2).toInt() == 1;
-               ui->table_Shaders->insertRow(curTableRow);
-               QTableWidgetItem *curShaderItem = new QTableWidgetItem(curShader);
-               curShaderItem->setFlags(curShaderItem->flags() & ~Qt::ItemIsEditable);
-               ui->table_Shaders->setItem(curTableRow, 0, curShaderItem);
-               QTableWidgetItem *settingItem = new QTableWidgetItem(curShaderEnabled ? "On" : "Off");
-               settingItem->setFlags(settingItem->flags() & ~Qt::ItemIsEditable);
-               ui->table_Shaders->setItem(curTableRow, 1, settingItem);
-               if (!shaderTooltip.isEmpty()) {
-                   shaderTooltip.prepend("<html><head/><body>").append("</body></html>");
-                   settingItem->setToolTip(shaderTooltip);
-               }
-               curTableRow++;
-               if (curShaderEnabled) {
-                   QString shortShader;
-                   shortShader.append(curShader).remove(0, 7);
-                   enabledShaders.append(shortShader).append(", ");
-               }
-               foundDefine = true;
-            }
-            continue;
+        m_settingsIndex.update(QString::fromUtf8(setting.name), QString::fromUtf8(setting.shader), m_shaderSettings.tooltipView(i));
+        if (curShaderEnabled) {
+            rows.append(i);
         }
-
-        // Reached the end of this shader's settings.
-        if (curLine.startsWith("#endif")) {
-            foundDefine = false;
-            foundSource = false;
-            foundDesc = false;
-            shaderTooltip.clear();
-            continue;
-        }
-
-        // Skip adding the setting / tooltip to the UI if the shader is disabled.
-        if (!curShaderEnabled) {
-            continue;
-        }
-
-        // Get the tooltip for the current setting.
-        if (curLine.startsWith("//")) {
-            curLine = curLine.remove(0, 2).trimmed();
-            curTooltip.append("<p>").append(curLine).append("</p>");
-        }
-
-        // Put the setting onto the UI with its tooltip.
-        bool isDefine = curLine.startsWith("#define");
-        if (isDefine || curLine.startsWith("uniform")) {
-            QRegularExpressionMatch matches;
-            matches.operator=(isDefine? setting1Regex.match(curLine) : setting2Regex.match(curLine));
-            if (matches.hasMatch()) {
-                ui->table_Shaders->insertRow(curTableRow);
-                QTableWidgetItem *nameItem = new QTableWidgetItem(matches.captured(1));
-                nameItem->setFlags(nameItem->flags() & ~Qt::ItemIsEditable);
-                QTableWidgetItem *settingItem = new QTableWidgetItem(matches.captured(2));
-                curTooltip = curTooltip.trimmed();
-                if (!curTooltip.isEmpty()) {
-                    curTooltip.prepend("<html><head/><body>").append("</body></html>");
-                    nameItem->setToolTip(curTooltip);
-                    settingItem->setToolTip(curTooltip);
-                }
-                ui->table_Shaders->setItem(curTableRow, 0, nameItem);
-                ui->table_Shaders->setItem(curTableRow, 1, settingItem);
-                curTableRow++;
-            }
-            curTooltip.clear();
+    }
+    m_settingsIndex.endUpdate();
+
+    // Tooltips are rendered by the items when they are hovered.
+    ui->table_Shaders->setRowCount(rows.size());
+    for (int row = 0; row < rows.size(); ++row) {
+        int index = rows.at(row);
+        const ShaderSettings::Setting &setting = settings.at(index);
+        QTableWidgetItem *nameItem, *settingItem;
+        if (setting.type == ShaderSettings::Enabled) {
+            nameItem = new QTableWidgetItem(QString("SHADER_").append(QString::fromUtf8(setting.shader)));
+            settingItem = new SettingItem(m_shaderSettings.value(index).toInt() == 1 ? "On" : "Off", &m_shaderSettings, index);
+            settingItem->setFlags(settingItem->flags() & ~Qt::ItemIsEditable);
+        } else {
+            nameItem = new SettingItem(QString::fromUtf8(setting.name), &m_shaderSettings, index);
+            settingItem = new SettingItem(QString::fromUtf8(m_shaderSettings.value(index)), &m_shaderSettings, index);
         }
+        nameItem->setFlags(nameItem->flags() & ~Qt::ItemIsEditable);
+        ui->table_Shaders->setItem(row, 0, nameItem);
+        ui->table_Shaders->setItem(row, 1, settingItem);
     }
     connect(ui->table_Shaders, &QTableWidget::itemChanged, this, &ShadersGUI::slotEditShaderSetting);
-    // Set enabled shaders list on the status tab.
-    if (enabledShaders.endsWith(", ")) {
-        enabledShaders.chop(2);
-        ui->value_ShadersEnabled->setText(enabledShaders);
-    } else {
-        ui->value_ShadersEnabled->setText("");
+    slotFilterShaders();
+
+    // Find the whitelist.
+    if (m_shaderSettings.hasWhitelist()) {
+        ui->value_Whitelist->setPlainText(QString::fromUtf8(m_shaderSettings.whitelist()));
     }
+
+    // Set enabled shaders list on the status tab.
+    ui->value_ShadersEnabled->setText(enabledShaders.join(", "));
+
     // Set the data on the shader order tab.
+    QStringList shaderOrder;
+    const QByteArrayList order = m_shaderSettings.order();
+    for (const QByteArray &shader : order) {
+        shaderOrder.append(QString::fromUtf8(shader));
+    }
     ui->value_ShaderOrder->clear();
     ui->value_ShaderOrder->addItems(shaderOrder);
 }
 
+/**
+ * @brief Only show the rows of the shader table matching the search box.
+ */
+void ShadersGUI::slotFilterShaders() {
+    QString query(ui->value_ShaderFilter->text().trimmed());
+    QSet<QString> matches;
+    if (!query.isEmpty()) {
+        matches = m_settingsIndex.match(query);
+    }
+    for (int row = 0; row < ui->table_Shaders->rowCount(); ++row) {
+        QTableWidgetItem *nameItem = ui->table_Shaders->item(row, 0);
+        bool hidden = !query.isEmpty() && (!nameItem || !matches.contains(nameItem->text()));
+        if (ui->table_Shaders->isRowHidden(row) != hidden) {
+            ui->table_Shaders->setRowHidden(row, hidden);
+        }
+    }
+}
+
 /**
  * @brief Reparse shader setting file if it's modified.
  */
 void ShadersGUI::slotShaderSettingsChanged() {
+    QFile settingsFile(m_shaderSettingsPath);
+    if (settingsFile.open(QFile::ReadOnly)) {
+        QByteArray shadersText(settingsFile.readAll());
+        settingsFile.close();
+        // Modified outside the GUI, keep the profile in sync.
+        if (!shadersText.isEmpty() && shadersText.operator!=(m_shadersText)) {
+            m_prevShadersText.clear();
+            m_prevShadersText.append(m_shadersText);
+            m_shadersText.swap(shadersText);
+            writeWhitelistMatcher();
+            saveActiveProfile();
+        }
+    }
     parseShadersText();
 }
@@ -18,6 +18,10 @@
 #ifndef SHADERSGUI_H
 #define SHADERSGUI_H
 
+#include "ProfileDelta.h"
+#include "ProfileListModel.h"
+#include "SessionRecorder.h"
+#include "SettingsIndex.h"
 #include <QFileSystemWatcher>
 #include <QListWidgetItem>
 #include <QMainWindow>
@@ -33,30 +37,47 @@ class ShadersGUI : public QMainWindow
     Q_OBJECT
 
 public:
-    ShadersGUI(QWidget *parent = nullptr);
+    ShadersGUI(const QString &settingsFile = QString(), QWidget *parent = nullptr);
     ~ShadersGUI();
 
+    void setSocketName(const QString &);
+    bool startRecording(const QString &);
+    bool replay(const SessionRecorder::Operation &);
+
 private:
     void processShaderPath(QString);
     void updateShadersText(QString);
     void updateShadersText(QByteArray);
+    bool writeShadersText();
+    void writeWhitelistMatcher();
     void parseShadersText();
     void watchSettingsFile();
     void unWatchSettingsFile();
-    void sortProfiles();
     void setProfileActive(QString);
-    void createProfileFile(QString);
+    void createProfileFile(const QByteArray &);
+    ProfileDelta readProfile(const QString &);
+    bool writeProfile(const QString &, const QByteArray &);
+    void saveActiveProfile();
+    void migrateProfiles();
     void setProfilesToUI();
     void connectToSocket();
+    ShaderSettings &shaderSettings();
+    QStringList pasteSettings(const QByteArray &);
+    int findSettingRow(const QString &) const;
 
     QString m_profilesPath;
     QString m_shaderPath;
     QString m_shaderSettingsPath;
-    QString m_oldProfileName;
+    QString m_socketName = "kwin_effect_shaders";
     const QString m_shaderSettingsName = "1_settings.glsl";
     QByteArray m_prevShadersText;
     QByteArray m_shadersText;
+    ShaderSettings m_baseSettings;
+    ShaderSettings m_shaderSettings;
+    SettingsIndex m_settingsIndex;
     QFileSystemWatcher m_shaderSettingsWatcher;
+    ProfileListModel m_profilesModel;
+    SessionRecorder m_recorder;
     QSettings *m_settings;
     Ui::ShadersGUI *ui;
 
@@ -64,6 +85,8 @@ private:
     void slotCloseWindow();
     void slotShaderSettingsChanged();
     void slotShaderSave();
+    void slotShaderSettingsCopy();
+    void slotShaderSettingsPaste();
     void slotMoveShaderUp();
     void slotMoveShaderDown();
     void slotUpdateShaderOrder();
@@ -73,9 +96,10 @@ private:
     void slotProfileDelete();
     void slotProfileCopy();
     void slotProfileChange(int);
-    void slotProfileRenamed(QListWidgetItem *);
-    void slotProfileMakeEditable(QListWidgetItem *);
+    void slotProfileRenamed(const QString &, const QString &);
+    void slotProfileRemoved(const QString &);
     void slotToggleShader(int, int);
     void slotEditShaderSetting(QTableWidgetItem *);
+    void slotFilterShaders();
 };
 #endif // SHADERSGUI_H
@@ -0,0 +1,330 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WhitelistMatcher.h"
+#include <QDataStream>
+#include <QMap>
+#include <QQueue>
+#include <QRegularExpression>
+#include <algorithm>
+
+static const QByteArray s_magic("KWSW");
+static const quint32 s_version = 1;
+
+/**
+ * @brief Construct an empty matcher.
+ */
+WhitelistMatcher::WhitelistMatcher() {
+    m_nodes.append(Node());
+}
+
+/**
+ * @brief Construct.
+ * @param whitelist : The whitelist, names separated by commas or white space.
+ */
+WhitelistMatcher::WhitelistMatcher(const QString &whitelist) {
+    QString normalized(normalize(whitelist));
+    compile(uncovered(normalized.isEmpty() ? QStringList() : normalized.split(',')));
+}
+
+/**
+ * @brief Canonical form of the whitelist: case folded, sorted, without duplicates.
+ *        Names covered by a prefix are kept, a compositor reading the //WHITELIST= line compares them literally.
+ * @param whitelist : Names separated by commas or white space.
+ * @return The patterns separated by commas.
+ */
+QString WhitelistMatcher::normalize(const QString &whitelist) {
+    QStringList patterns;
+    const QStringList entries = QString(whitelist).remove('"').toCaseFolded().split(QRegularExpression("[,\\s]+"));
+    for (const QString &entry : entries) {
+        QString pattern(entry);
+        // ** is the same as *.
+        while (pattern.contains("**")) {
+            pattern.replace("**", "*");
+        }
+        if (!pattern.isEmpty()) {
+            patterns.append(pattern);
+        }
+    }
+    std::sort(patterns.begin(), patterns.end());
+    patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+    return patterns.join(',');
+}
+
+/**
+ * @brief Drop the patterns a prefix pattern already matches, they would only add nodes to the trie.
+ * @param patterns : Normalized patterns, sorted.
+ */
+QStringList WhitelistMatcher::uncovered(const QStringList &patterns) {
+    QStringList heads;
+    for (const QString &pattern : patterns) {
+        int wildcard = wildcardIndex(pattern);
+        if (wildcard == pattern.size() - 1 && pattern.at(wildcard) == '*') {
+            heads.append(pattern.left(wildcard));
+        }
+    }
+    // Sorted, a prefix comes right before the prefixes it covers, so the covering one is always the last kept.
+    std::sort(heads.begin(), heads.end());
+    QStringList prefixes;
+    for (const QString &head : heads) {
+        if (prefixes.isEmpty() || !head.startsWith(prefixes.last())) {
+            prefixes.append(head);
+        }
+    }
+    // Drop patterns whose head starts with a shorter prefix, with a minimal set of prefixes,
+    // only the last prefix sorted before the head can be a prefix of it.
+    QStringList kept;
+    for (const QString &pattern : patterns) {
+        int wildcard = wildcardIndex(pattern);
+        QString head(pattern.left(wildcard));
+        bool isPrefix = wildcard == pattern.size() - 1 && pattern.at(wildcard) == '*';
+        auto it = std::upper_bound(prefixes.cbegin(), prefixes.cend(), head);
+        if (it != prefixes.cbegin()) {
+            const QString &prefix = *(it - 1);
+            if (head.startsWith(prefix) && !(isPrefix && prefix == head)) {
+                continue;
+            }
+        }
+        kept.append(pattern);
+    }
+    return kept;
+}
+
+/**
+ * @brief Check if there are no patterns, an empty whitelist processes every application.
+ */
+bool WhitelistMatcher::isEmpty() const {
+    const Node &root = m_nodes.first();
+    return !root.edgeCount && !root.flags && !root.globCount;
+}
+
+/**
+ * @brief Check if a window class name matches a pattern.
+ * @param name
+ */
+bool WhitelistMatcher::matches(const QString &name) const {
+    const QByteArray bytes(name.toCaseFolded().toUtf8());
+    quint32 node = 0;
+    for (int i = 0; ; ++i) {
+        const Node &curNode = m_nodes.at(node);
+        if (curNode.flags & Prefix) {
+            return true;
+        }
+        for (quint32 glob = curNode.firstGlob; glob < curNode.firstGlob + curNode.globCount; ++glob) {
+            if (globMatch(m_globs.at(glob), bytes, i)) {
+                return true;
+            }
+        }
+        if (i == bytes.size()) {
+            return curNode.flags & Exact;
+        }
+        quint32 byte = static_cast<quint8>(bytes.at(i));
+        auto first = m_edges.cbegin() + curNode.firstEdge;
+        auto last = first + curNode.edgeCount;
+        auto edge = std::lower_bound(first, last, byte, [](const Edge &curEdge, quint32 curByte) {
+            return curEdge.byte < curByte;
+        });
+        if (edge == last || edge->byte != byte) {
+            return false;
+        }
+        node = edge->node;
+    }
+}
+
+/**
+ * @brief Write the compiled trie, see the class description for the format.
+ */
+QByteArray WhitelistMatcher::serialize() const {
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(s_magic.constData(), s_magic.size());
+    stream << s_version << quint32(m_nodes.size()) << quint32(m_edges.size()) << quint32(m_globs.size());
+    for (const Node &node : m_nodes) {
+        stream << node.firstEdge << node.edgeCount << node.flags << node.firstGlob << node.globCount;
+    }
+    for (const Edge &edge : m_edges) {
+        stream << edge.byte << edge.node;
+    }
+    for (const QByteArray &glob : m_globs) {
+        stream << quint32(glob.size());
+        stream.writeRawData(glob.constData(), glob.size());
+    }
+    return data;
+}
+
+/**
+ * @brief Read a compiled trie written by serialize().
+ * @param data
+ * @return False if the data is not a valid trie, the matcher is then empty.
+ */
+bool WhitelistMatcher::load(const QByteArray &data) {
+    *this = WhitelistMatcher();
+    if (!data.startsWith(s_magic)) {
+        return false;
+    }
+    QDataStream stream(data.mid(s_magic.size()));
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 version, nodeCount, edgeCount, globCount;
+    stream >> version >> nodeCount >> edgeCount >> globCount;
+    // Every node, edge or glob takes at least 4 bytes, don't allocate more than the data can hold.
+    quint64 maxCount = static_cast<quint64>(data.size()) / 4;
+    if (stream.status() != QDataStream::Ok || version != s_version || !nodeCount
+        || nodeCount > maxCount || edgeCount > maxCount || globCount > maxCount) {
+        return false;
+    }
+    QVector<Node> nodes(static_cast<int>(nodeCount));
+    QVector<Edge> edges(static_cast<int>(edgeCount));
+    QByteArrayList globs;
+    for (Node &node : nodes) {
+        stream >> node.firstEdge >> node.edgeCount >> node.flags >> node.firstGlob >> node.globCount;
+        if (static_cast<quint64>(node.firstEdge) + node.edgeCount > edgeCount
+            || static_cast<quint64>(node.firstGlob) + node.globCount > globCount) {
+            return false;
+        }
+    }
+    for (Edge &edge : edges) {
+        stream >> edge.byte >> edge.node;
+        // Every edge consumes a byte of the name, so a walk always ends, even on a malformed trie.
+        if (edge.byte > 255 || edge.node >= nodeCount) {
+            return false;
+        }
+    }
+    for (quint32 i = 0; i < globCount; ++i) {
+        quint32 length;
+        stream >> length;
+        if (stream.status() != QDataStream::Ok || length > static_cast<quint64>(data.size())) {
+            return false;
+        }
+        QByteArray glob(static_cast<int>(length), '\0');
+        if (stream.readRawData(glob.data(), static_cast<int>(length)) != static_cast<int>(length)) {
+            return false;
+        }
+        globs.append(glob);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    m_nodes.swap(nodes);
+    m_edges.swap(edges);
+    m_globs.swap(globs);
+    return true;
+}
+
+/**
+ * @brief Position of the first wildcard of a pattern.
+ * @param pattern
+ * @return The position, the size of the pattern if it has none.
+ */
+int WhitelistMatcher::wildcardIndex(const QString &pattern) {
+    for (int i = 0; i < pattern.size(); ++i) {
+        if (pattern.at(i) == '*' || pattern.at(i) == '?') {
+            return i;
+        }
+    }
+    return pattern.size();
+}
+
+/**
+ * @brief Match the rest of a name against a glob, backtracking to the last * on a mismatch.
+ * @param glob  : The pattern starting at its first wildcard.
+ * @param name  : The case folded name.
+ * @param start : Where the rest of the name starts.
+ */
+bool WhitelistMatcher::globMatch(const QByteArray &glob, const QByteArray &name, int start) {
+    int g = 0, n = start, starG = -1, starN = 0;
+    while (n < name.size()) {
+        if (g < glob.size() && (glob.at(g) == '?' || glob.at(g) == name.at(n))) {
+            ++g;
+            ++n;
+        } else if (g < glob.size() && glob.at(g) == '*') {
+            starG = g++;
+            starN = n;
+        } else if (starG >= 0) {
+            g = starG + 1;
+            n = ++starN;
+        } else {
+            return false;
+        }
+    }
+    while (g < glob.size() && glob.at(g) == '*') {
+        ++g;
+    }
+    return g == glob.size();
+}
+
+/**
+ * @brief Build the trie, nodes are numbered breadth first so the edges of a node are contiguous.
+ * @param patterns : Normalized patterns.
+ */
+void WhitelistMatcher::compile(const QStringList &patterns) {
+    struct BuildNode {
+        QMap<quint8, int> children;
+        quint32 flags = 0;
+        QByteArrayList globs;
+    };
+    QVector<BuildNode> buildNodes(1);
+    for (const QString &pattern : patterns) {
+        int wildcard = wildcardIndex(pattern);
+        const QByteArray head(pattern.left(wildcard).toUtf8());
+        int node = 0;
+        for (char c : head) {
+            quint8 byte = static_cast<quint8>(c);
+            int child = buildNodes.at(node).children.value(byte, -1);
+            if (child < 0) {
+                child = buildNodes.size();
+                buildNodes[node].children.insert(byte, child);
+                buildNodes.append(BuildNode());
+            }
+            node = child;
+        }
+        if (wildcard == pattern.size()) {
+            buildNodes[node].flags |= Exact;
+        } else if (wildcard == pattern.size() - 1 && pattern.at(wildcard) == '*') {
+            buildNodes[node].flags |= Prefix;
+        } else {
+            buildNodes[node].globs.append(pattern.mid(wildcard).toUtf8());
+        }
+    }
+
+    m_nodes.clear();
+    m_edges.clear();
+    m_globs.clear();
+    QVector<quint32> index(buildNodes.size());
+    QQueue<int> queue;
+    queue.enqueue(0);
+    quint32 nextIndex = 1;
+    while (!queue.isEmpty()) {
+        const BuildNode &buildNode = buildNodes.at(queue.dequeue());
+        Node node;
+        node.flags = buildNode.flags;
+        node.firstEdge = m_edges.size();
+        node.edgeCount = buildNode.children.size();
+        node.firstGlob = m_globs.size();
+        node.globCount = buildNode.globs.size();
+        for (auto it = buildNode.children.cbegin(); it != buildNode.children.cend(); ++it) {
+            index[it.value()] = nextIndex++;
+            Edge edge;
+            edge.byte = it.key();
+            edge.node = index.at(it.value());
+            m_edges.append(edge);
+            queue.enqueue(it.value());
+        }
+        m_globs.append(buildNode.globs);
+        m_nodes.append(node);
+    }
+}
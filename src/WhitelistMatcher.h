@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WHITELISTMATCHER_H
+#define WHITELISTMATCHER_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Matches window class names against the whitelist.
+ *        A pattern is a name, a prefix (steam_app_*) or a glob, * matches any characters, ? one character.
+ *        Matching is case insensitive, names and patterns are case folded.
+ *        Patterns covered by a prefix are only dropped from the trie, normalize() keeps them.
+ *
+ *        The patterns are compiled into a trie of their literal heads (the part before the first wildcard),
+ *        names and prefixes are answered by walking the name down the trie, O(name length), only globs with a
+ *        wildcard in the middle compare the rest of the name.
+ *
+ *        serialize() writes the trie so the compositor doesn't have to parse the whitelist, little endian:
+ *        "KWSW" quint32 version(1) quint32 nodes quint32 edges quint32 globs
+ *        nodes * (quint32 firstEdge, quint32 edgeCount, quint32 flags (1 name ends here, 2 prefix ends here),
+ *                 quint32 firstGlob, quint32 globCount)
+ *        edges * (quint32 byte, quint32 node), sorted by byte per node
+ *        globs * (quint32 length, bytes), the rest of the pattern starting at its first wildcard
+ *        Node 0 is the root.
+ */
+class WhitelistMatcher
+{
+public:
+    WhitelistMatcher();
+    explicit WhitelistMatcher(const QString &);
+
+    static QString normalize(const QString &);
+    bool isEmpty() const;
+    bool matches(const QString &) const;
+    QByteArray serialize() const;
+    bool load(const QByteArray &);
+
+private:
+    enum Flags {
+        Exact = 1,
+        Prefix = 2
+    };
+
+    struct Node {
+        quint32 firstEdge = 0;
+        quint32 edgeCount = 0;
+        quint32 flags = 0;
+        quint32 firstGlob = 0;
+        quint32 globCount = 0;
+    };
+
+    struct Edge {
+        quint32 byte = 0;
+        quint32 node = 0;
+    };
+
+    static QStringList uncovered(const QStringList &);
+    static int wildcardIndex(const QString &);
+    static bool globMatch(const QByteArray &, const QByteArray &, int);
+    void compile(const QStringList &);
+
+    QVector<Node> m_nodes;
+    QVector<Edge> m_edges;
+    QByteArrayList m_globs;
+};
+#endif // WHITELISTMATCHER_H
@@ -16,11 +16,223 @@
  */
 
 #include "ShadersGUI.h"
+#include "ProfileMigrator.h"
+#include "SessionReplayer.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
 #include <QSharedMemory>
+#include <QStandardPaths>
+#include <QTextStream>
+
+/**
+ * @brief Find the shader path to work on.
+ *
+ * @param shaderPath -> The shader path given on the command line, the configured one if empty.
+ */
+static QString resolveShaderPath(QString shaderPath) {
+    if (shaderPath.isEmpty()) {
+        shaderPath = QSettings("kevinlekiller", "kwin_effect_shaders").value("ShaderPath").toString().trimmed();
+    }
+    if (shaderPath.isEmpty()) {
+        shaderPath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, "kwin-effect-shaders_shaders", QStandardPaths::LocateDirectory);
+    }
+    if (!shaderPath.endsWith("/")) {
+        shaderPath.append("/");
+    }
+    return shaderPath;
+}
+
+/**
+ * @brief Rebase the profiles onto the shader path's example file without opening the GUI.
+ *
+ * @param shaderPath -> The shader path, the configured one if empty.
+ * @param dryRun     -> Only print what would change.
+ */
+static int migrateProfiles(QString shaderPath, bool dryRun) {
+    QTextStream out(stdout);
+    shaderPath = resolveShaderPath(shaderPath);
+    QFile exampleFile(QString(shaderPath).append("1_settings.glsl.example"));
+    if (!exampleFile.open(QFile::ReadOnly)) {
+        out << "Could not read " << exampleFile.fileName() << "\n";
+        return EXIT_FAILURE;
+    }
+    ShaderSettings base(exampleFile.readAll());
+    QString profilesPath(QString(shaderPath).append("p/"));
+    QDir profilesDir(profilesPath);
+    profilesDir.setNameFilters(QStringList() << "*.p");
+    profilesDir.setFilter(QDir::Files);
+    profilesDir.setSorting(QDir::Name);
+    QStringList profiles(profilesDir.entryList());
+    for (QString &curProfile : profiles) {
+        curProfile.chop(2);
+    }
+
+    ProfileMigrator migrator(base, profilesPath);
+    // Older versions linked the settings file to the active profile, it would read the rewritten profile.
+    QString settingsPath(QString(shaderPath).append("1_settings.glsl"));
+    if (QFileInfo(settingsPath).isSymLink()) {
+        if (dryRun) {
+            out << "1_settings.glsl links to a profile, it would be replaced by a copy of the profile." << "\n";
+        } else if (!migrator.materializeSettingsFile(settingsPath)) {
+            out << "1_settings.glsl links to a profile and could not be replaced by a copy, no profile was changed." << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    QVector<ProfileMigrator::Report> reports(migrator.migrate(profiles, dryRun));
+    int migrated = 0, failed = 0;
+    for (const ProfileMigrator::Report &report : reports) {
+        if (report.failed) {
+            failed++;
+        } else if (report.migrated) {
+            migrated++;
+        }
+    }
+    QString summary(ProfileMigrator::summary(reports));
+    if (!summary.isEmpty()) {
+        out << summary << "\n";
+    }
+    out << migrated << " of " << reports.size() << (dryRun ? " profiles would be updated" : " profiles updated");
+    out << ", " << failed << " failed." << "\n";
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Check that a settings file can be edited safely without opening the GUI.
+ *        Every value is changed and changed back, which has to give back the same file, and the parse time
+ *        of the file repeated up to 8 times has to grow with its size.
+ *
+ * @param path -> The settings file.
+ */
+static int checkSettings(const QString &path) {
+    QTextStream out(stdout);
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        out << "Could not read " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    const QByteArray text(file.readAll());
+    file.close();
+
+    bool failed = false;
+    QElapsedTimer timer;
+    double firstRate = 0;
+    for (int copies = 1; copies <= 8; copies *= 2) {
+        const QByteArray input(text.repeated(copies));
+        qint64 best = -1;
+        int settingsCount = 0;
+        // Best of 3, the first parse also pays for allocations.
+        for (int run = 0; run < 3; ++run) {
+            timer.start();
+            ShaderSettings parsed(input);
+            qint64 elapsed = timer.nsecsElapsed();
+            settingsCount = parsed.settings().size();
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        double rate = static_cast<double>(best) / (input.isEmpty() ? 1 : input.size());
+        if (copies == 1) {
+            firstRate = rate;
+        }
+        out << QString("Parsed %1 bytes, %2 settings in %3 ms.").arg(input.size()).arg(settingsCount).arg(best / 1e6, 0, 'f', 3) << "\n";
+        if (copies == 8 && firstRate > 0 && rate > firstRate * 4) {
+            out << "Parse time grows faster than the size of the file." << "\n";
+            failed = true;
+        }
+    }
+
+    ShaderSettings settings(text);
+    int shaders = 0, notEditable = 0, roundTrips = 0;
+    const QVector<ShaderSettings::Setting> curSettings = settings.settings();
+    for (int i = 0; i < curSettings.size(); ++i) {
+        const ShaderSettings::Setting &setting = curSettings.at(i);
+        if (setting.type == ShaderSettings::Enabled) {
+            shaders++;
+        }
+        if (settings.indexOf(setting.name) != i) {
+            continue;
+        }
+        const QByteArray value(settings.value(i));
+        if (!settings.isValidValue(i, value)) {
+            out << "Can not be edited, the value doesn't match its type: " << setting.name << "=" << value << "\n";
+            notEditable++;
+            continue;
+        }
+        const QByteArray newValue(settings.changedValue(i));
+        if (newValue.isEmpty()) {
+            out << "Can not be edited, no other value of its type was found: " << setting.name << "=" << value << "\n";
+            notEditable++;
+            continue;
+        }
+        if (!settings.setValue(setting.name, newValue) || settings.value(i) != newValue
+            || !settings.setValue(setting.name, value) || settings.text() != text) {
+            out << "Editing changed more than the value: " << setting.name << "\n";
+            out << settings.errors().join("\n") << "\n";
+            settings.setText(text);
+            failed = true;
+            continue;
+        }
+        roundTrips++;
+    }
+    if (settings.hasWhitelist() && (!settings.setWhitelist(settings.whitelist()) || settings.text() != text)) {
+        out << "Rewriting the whitelist changed the file." << "\n";
+        failed = true;
+    }
+    // The order block is rewritten in its own layout, only the order has to stay the same.
+    if (settings.hasOrder() && (!settings.setOrder(settings.order()) || settings.order() != ShaderSettings(text).order())) {
+        out << "Rewriting the shader order changed it." << "\n";
+        failed = true;
+    }
+    out << shaders << " shaders, " << roundTrips << " settings edited and restored, " << notEditable << " not editable." << "\n";
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
 int main(int argc, char *argv[]) {
+    // Replaying, checking and migrating don't show the GUI, don't require a display.
+    const QByteArrayList headlessOptions = {"--replay", "--check-settings", "--migrate-profiles"};
+    for (int i = 1; i < argc && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"); ++i) {
+        const QByteArray arg(argv[i]);
+        for (const QByteArray &option : headlessOptions) {
+            if (arg == option || arg.startsWith(option + "=")) {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+                break;
+            }
+        }
+    }
     QApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption migrateOption("migrate-profiles", "Update the profiles to the current 1_settings.glsl.example and exit.");
+    QCommandLineOption dryRunOption("dry-run", "With --migrate-profiles, only report what would change.");
+    QCommandLineOption shaderPathOption("shader-path", "Shader path to use instead of the configured one.", "path");
+    parser.addOption(migrateOption);
+    parser.addOption(dryRunOption);
+    QCommandLineOption recordOption("record", "Record the operations of this session to a file.", "file");
+    QCommandLineOption replayOption("replay", "Replay a recorded session on a copy of the shader path, report the time per operation and exit.", "file");
+    QCommandLineOption maxSpeedOption("max-speed", "With --replay, don't wait between operations.");
+    QCommandLineOption checkOption("check-settings", "Check that a settings file can be edited without changing anything else and exit.", "file");
+    parser.addOption(shaderPathOption);
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(maxSpeedOption);
+    parser.addOption(checkOption);
+    parser.process(a);
+    if (parser.isSet(checkOption)) {
+        return checkSettings(parser.value(checkOption));
+    }
+    if (parser.isSet(migrateOption)) {
+        return migrateProfiles(parser.value(shaderPathOption).trimmed(), parser.isSet(dryRunOption));
+    }
+    if (parser.isSet(replayOption)) {
+        QTextStream out(stdout);
+        SessionReplayer replayer(resolveShaderPath(parser.value(shaderPathOption).trimmed()), parser.isSet(maxSpeedOption));
+        return replayer.replay(parser.value(replayOption), out);
+    }
     QSharedMemory shm("kwin-effect-shader_gui-shm");
     if (shm.attach(QSharedMemory::ReadOnly)) {
         // In case previous process died unexpectedly. https://doc.qt.io/qt-5/qsharedmemory.html#details
@@ -33,6 +245,9 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
     ShadersGUI w;
+    if (parser.isSet(recordOption) && !w.startRecording(parser.value(recordOption))) {
+        QTextStream(stderr) << "Could not create the recording " << parser.value(recordOption) << "\n";
+    }
     w.show();
     int ret = a.exec();
     shm.detach();
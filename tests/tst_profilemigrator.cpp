@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileDelta.h"
+#include "ProfileMigrator.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief Example file with 10 settings per shader.
+ * @param shaders    : Number of shaders.
+ * @param oldSetting : Add a setting the newer example file doesn't have.
+ */
+static QByteArray exampleText(int shaders, bool oldSetting) {
+    QByteArray text("const int SHADER_ORDER[] = int[](\n");
+    for (int shader = 0; shader < shaders; ++shader) {
+        text.append("    SHADER_S").append(QByteArray::number(shader)).append(",\n");
+    }
+    text.append("SHADERS);\n//WHITELIST=\"\"\n\n");
+    for (int shader = 0; shader < shaders; ++shader) {
+        QByteArray name("S");
+        name.append(QByteArray::number(shader));
+        text.append("// Description: Shader ").append(name).append(".\n// Source: https://example.com/\n");
+        text.append("#define ").append(name).append("_ENABLED 0\n");
+        text.append("#if ").append(name).append("_ENABLED == 1\n");
+        for (int setting = 0; setting < 10; ++setting) {
+            text.append("// Setting ").append(QByteArray::number(setting)).append(".\n");
+            text.append("#define ").append(name).append("_SETTING").append(QByteArray::number(setting));
+            text.append(" ").append(QByteArray::number(setting)).append("\n");
+        }
+        if (oldSetting) {
+            text.append("#define ").append(name).append("_OLD 1\n");
+        }
+        text.append("#endif\n\n");
+    }
+    return text;
+}
+
+class TestProfileMigrator : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void migrate();
+    void migrateProfiles();
+
+private:
+    void writeProfiles();
+
+    QTemporaryDir m_dir;
+    QString m_profilesPath;
+    QStringList m_profiles;
+    ShaderSettings m_oldBase;
+    ShaderSettings m_base;
+};
+
+void TestProfileMigrator::initTestCase() {
+    QVERIFY(m_dir.isValid());
+    m_profilesPath = m_dir.path() + "/p/";
+    QVERIFY(QDir().mkpath(m_profilesPath));
+    // The new example file dropped the _OLD settings and gained a shader.
+    m_oldBase.setText(exampleText(39, true));
+    m_base.setText(exampleText(40, false));
+    for (int i = 0; i < 150; ++i) {
+        m_profiles.append(QString("profile%1").arg(i));
+    }
+}
+
+/**
+ * @brief Profiles saved against the old example file, every other one a full copy from older versions.
+ */
+void TestProfileMigrator::writeProfiles() {
+    for (int i = 0; i < m_profiles.size(); ++i) {
+        ShaderSettings settings(m_oldBase);
+        QByteArray shader("S");
+        shader.append(QByteArray::number(i % 39));
+        QVERIFY(settings.setEnabled(shader, true));
+        QVERIFY(settings.setValue(shader + "_SETTING1", QByteArray::number(100 + i)));
+        QVERIFY(settings.setValue(shader + "_OLD", "5"));
+        QFile profileFile(m_profilesPath + m_profiles.at(i) + ".p");
+        QVERIFY(profileFile.open(QFile::WriteOnly | QFile::Truncate));
+        profileFile.write(i % 2 ? settings.text() : ProfileDelta::fromSettings(m_oldBase, settings).serialize());
+    }
+}
+
+/**
+ * @brief The values are kept on the new example file, values it doesn't have are reported, a second run changes nothing.
+ */
+void TestProfileMigrator::migrate() {
+    writeProfiles();
+    ProfileMigrator migrator(m_base, m_profilesPath);
+    const QVector<ProfileMigrator::Report> reports = migrator.migrate(m_profiles, false);
+    QCOMPARE(reports.size(), m_profiles.size());
+    for (int i = 0; i < reports.size(); ++i) {
+        const ProfileMigrator::Report &report = reports.at(i);
+        QVERIFY(report.migrated);
+        QVERIFY(!report.failed);
+        QCOMPARE(report.legacy, i % 2 == 1);
+        QVERIFY(report.droppedValues.contains(QByteArray("S").append(QByteArray::number(i % 39)).append("_OLD")));
+    }
+
+    QFile profileFile(m_profilesPath + "profile7.p");
+    QVERIFY(profileFile.open(QFile::ReadOnly));
+    ProfileDelta delta;
+    QVERIFY(delta.parse(profileFile.readAll()));
+    QCOMPARE(delta.baseHash, m_base.hash());
+    ShaderSettings settings(delta.apply(m_base));
+    QCOMPARE(settings.value(QByteArray("S7_ENABLED")), QByteArray("1"));
+    QCOMPARE(settings.value(QByteArray("S7_SETTING1")), QByteArray("107"));
+
+    const QVector<ProfileMigrator::Report> again = migrator.migrate(m_profiles, false);
+    for (const ProfileMigrator::Report &report : again) {
+        QVERIFY(!report.migrated);
+    }
+}
+
+/**
+ * @brief Migrating 150 profiles, like the first start after the shader pack was updated.
+ */
+void TestProfileMigrator::migrateProfiles() {
+    writeProfiles();
+    ProfileMigrator migrator(m_base, m_profilesPath);
+    QBENCHMARK {
+        // A dry run, so every iteration migrates the same profiles.
+        migrator.migrate(m_profiles, true);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestProfileMigrator)
+#include "tst_profilemigrator.moc"
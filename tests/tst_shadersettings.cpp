@@ -0,0 +1,341 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileDelta.h"
+#include "SettingItem.h"
+#include "SettingsIndex.h"
+#include "ShaderSettings.h"
+#include <QtTest>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/**
+ * @brief Bytes of heap in use, 0 if the C library doesn't report it.
+ */
+static qint64 heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    // Large blocks are mapped separately, they are not part of uordblks.
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Settings buffer laid out like 1_settings.glsl.example.
+ * @param shaders  : Number of shaders.
+ * @param settings : Number of settings per shader.
+ */
+static QByteArray settingsBuffer(int shaders, int settings) {
+    QByteArray text("const int SHADER_ORDER[] = int[](\n");
+    for (int shader = 0; shader < shaders; ++shader) {
+        text.append("    SHADER_S").append(QByteArray::number(shader)).append(",\n");
+    }
+    text.append("SHADERS);\n//WHITELIST=\"kate,kcalc\"\n\n");
+    for (int shader = 0; shader < shaders; ++shader) {
+        QByteArray name("S");
+        name.append(QByteArray::number(shader));
+        text.append("// Description: Shader number ").append(name).append(" adjusts the colors of the window.\n");
+        text.append("// Source: https://example.com/").append(name).append("\n");
+        text.append("#define ").append(name).append("_ENABLED 0\n");
+        text.append("#if ").append(name).append("_ENABLED == 1\n");
+        for (int setting = 0; setting < settings; ++setting) {
+            QByteArray settingName(name);
+            settingName.append("_SETTING").append(QByteArray::number(setting));
+            text.append("// Strength of the effect, between 0.0 and 1.0.\n");
+            text.append("// Higher values are slower.\n");
+            if (setting % 2) {
+                text.append("#define ").append(settingName).append(" 0.5\n");
+            } else {
+                text.append("uniform float ").append(settingName).append(" = 0.5;\n");
+            }
+        }
+        text.append("#endif\n\n");
+    }
+    return text;
+}
+
+class TestShaderSettings : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void tooltips();
+    void sectionGuards();
+    void transactionRollsBack();
+    void transactionJoined();
+    void inconsistentEditRejected();
+    void pasteBlockErrors();
+    void changedValues();
+    void indexKeepsCommentWords();
+    void eagerTooltips();
+    void lazyTooltips();
+    void eagerTooltipsHeap();
+    void lazyTooltipsHeap();
+};
+
+/**
+ * @brief The comments are found as ranges of the buffer.
+ */
+void TestShaderSettings::tooltips() {
+    ShaderSettings settings(settingsBuffer(2, 2));
+    QCOMPARE(settings.settings().size(), 6);
+    QVERIFY(settings.tooltip(0).startsWith("// Description: Shader number S0"));
+    QVERIFY(settings.tooltip(0).endsWith("https://example.com/S0"));
+    QCOMPARE(settings.tooltip(1), QByteArray("// Strength of the effect, between 0.0 and 1.0.\n// Higher values are slower."));
+    QCOMPARE(settings.tooltipView(1), settings.tooltip(1));
+    QVERIFY(SettingItem::renderTooltip(settings.tooltip(1), false).contains("<p>Higher values are slower.</p>"));
+}
+
+/**
+ * @brief A section guarded by #ifdef or defined() closes at its #endif, nested conditionals don't close it.
+ */
+void TestShaderSettings::sectionGuards() {
+    ShaderSettings settings(
+        "// Description: First\n// Source: https://example.com/A\n"
+        "#define A_ENABLED 1\n"
+        "#if defined(A_ENABLED) && A_ENABLED > 0\n"
+        "#define A_STRENGTH 1\n"
+        "#ifdef A_EXTRA\n"
+        "#define A_EXTRA_STRENGTH 2\n"
+        "#endif\n"
+        "#define A_AFTER 3\n"
+        "#endif\n"
+        "\n"
+        "// Description: Second\n// Source: https://example.com/B\n"
+        "#define B_ENABLED 0\n"
+        "#ifdef B_FAST\n"
+        "#define B_STRENGTH 4\n"
+        "#endif\n"
+        "\n"
+        "// Description: Third\n// Source: https://example.com/C\n"
+        "#define C_ENABLED 1\n"
+        "#if C_ENABLED == 1\n"
+        "#define C_STRENGTH 5\n"
+        "#endif\n");
+    QCOMPARE(settings.settings().size(), 8);
+    QCOMPARE(settings.settings().at(3).name, QByteArray("A_AFTER"));
+    QCOMPARE(settings.settings().at(3).shader, QByteArray("A"));
+    QCOMPARE(settings.settings().at(4).type, ShaderSettings::Enabled);
+    QCOMPARE(settings.settings().at(4).shader, QByteArray("B"));
+    QCOMPARE(settings.settings().at(5).shader, QByteArray("B"));
+    QCOMPARE(settings.settings().at(6).type, ShaderSettings::Enabled);
+    QCOMPARE(settings.settings().at(6).shader, QByteArray("C"));
+    QCOMPARE(settings.tooltip(6), QByteArray("// Description: Third\n// Source: https://example.com/C"));
+    QVERIFY(settings.isConsistent());
+}
+
+/**
+ * @brief One invalid value reverts every change of the transaction.
+ */
+void TestShaderSettings::transactionRollsBack() {
+    ShaderSettings settings(settingsBuffer(2, 2));
+    const QByteArray text(settings.text());
+    QVERIFY(settings.begin());
+    QVERIFY(settings.setValue("S0_SETTING0", "0.75"));
+    QVERIFY(settings.setEnabled("S1", true));
+    QVERIFY(!settings.setValue("S0_SETTING1", "fast"));
+    QVERIFY(settings.setOrder(QByteArrayList() << "S1" << "S0"));
+    QVERIFY(!settings.commit());
+    QVERIFY(!settings.inTransaction());
+    QCOMPARE(settings.errors().size(), 1);
+    QCOMPARE(settings.text(), text);
+    QCOMPARE(settings.value(QByteArray("S0_SETTING0")), QByteArray("0.5"));
+    QCOMPARE(settings.order(), QByteArrayList() << "S0" << "S1");
+
+    // Outside of a transaction, a change is its own transaction.
+    QVERIFY(settings.setValue("S0_SETTING0", "0.75"));
+    QVERIFY(!settings.inTransaction());
+    QCOMPARE(settings.value(QByteArray("S0_SETTING0")), QByteArray("0.75"));
+}
+
+/**
+ * @brief Changes made while the caller has a transaction open join it, they are only kept when the caller commits.
+ */
+void TestShaderSettings::transactionJoined() {
+    ShaderSettings settings(settingsBuffer(2, 2));
+    const QByteArray text(settings.text());
+    QVERIFY(settings.begin());
+    // Already in a transaction.
+    QVERIFY(!settings.begin());
+    QVERIFY(settings.setValue("S0_SETTING0", "0.75"));
+    ProfileDelta delta;
+    QVERIFY(delta.parseBlock("S1_SETTING1=2\n@order=S1,S0\n").isEmpty());
+    QVERIFY(delta.applyTo(settings));
+    QVERIFY(settings.inTransaction());
+    QCOMPARE(settings.value(QByteArray("S1_SETTING1")), QByteArray("2"));
+    settings.rollback();
+    QCOMPARE(settings.text(), text);
+
+    QVERIFY(settings.begin());
+    QVERIFY(settings.setValue("S0_SETTING0", "0.75"));
+    QVERIFY(delta.applyTo(settings));
+    QVERIFY(settings.commit());
+    QCOMPARE(settings.value(QByteArray("S0_SETTING0")), QByteArray("0.75"));
+    QCOMPARE(settings.value(QByteArray("S1_SETTING1")), QByteArray("2"));
+    QCOMPARE(settings.order(), QByteArrayList() << "S1" << "S0");
+}
+
+/**
+ * @brief A value that fits the first definition of a name but not a later one would change what the file parses to.
+ */
+void TestShaderSettings::inconsistentEditRejected() {
+    ShaderSettings settings(
+        "// Description: A\n// Source: https://example.com/A\n"
+        "#define A_ENABLED 1\n"
+        "#if A_ENABLED == 1\n"
+        "uniform bool A_MODE = true;\n"
+        "#define A_MODE true\n"
+        "#endif\n");
+    const QByteArray text(settings.text());
+    QVERIFY(settings.isConsistent());
+    QVERIFY(settings.isValidValue(settings.indexOf("A_MODE"), "fast mode"));
+    // #define A_MODE fast mode would parse as "fast".
+    QVERIFY(!settings.setValue("A_MODE", "fast mode"));
+    QCOMPARE(settings.text(), text);
+    QVERIFY(!settings.errors().isEmpty());
+    QVERIFY(settings.setValue("A_MODE", "false"));
+    QVERIFY(settings.isConsistent());
+}
+
+/**
+ * @brief Lines of a pasted block that can't be read are reported, so the block is rejected as a whole.
+ */
+void TestShaderSettings::pasteBlockErrors() {
+    ProfileDelta delta;
+    QVERIFY(delta.parseBlock("# comment\n\n// comment\nS0_SETTING0=1\n").isEmpty());
+    QCOMPARE(delta.values.size(), 1);
+    QCOMPARE(delta.parseBlock("S0_SETTING0=1\nS0_SETTING1 2\n=3\n@unknown=4\n").size(), 3);
+
+    // A pasted whitelist is stored the way the whitelist tab saves it.
+    ShaderSettings settings(settingsBuffer(1, 1));
+    QVERIFY(delta.parseBlock("@whitelist=Steam_App_*, kate kate\n").isEmpty());
+    QVERIFY(delta.applyTo(settings));
+    QCOMPARE(settings.whitelist(), QByteArray("kate,steam_app_*"));
+}
+
+/**
+ * @brief changedValue() gives a different value of the same type.
+ */
+void TestShaderSettings::changedValues() {
+    ShaderSettings settings(
+        "// Description: A\n// Source: https://example.com/A\n"
+        "#define A_ENABLED 0\n"
+        "#if A_ENABLED == 1\n"
+        "#define A_INT 9\n"
+        "uniform float A_FLOAT = -0.5;\n"
+        "uniform vec3 A_VEC = vec3(1.0, 1.1, -0.9);\n"
+        "#define A_MODE luma\n"
+        "#endif\n");
+    QCOMPARE(settings.changedValue(0), QByteArray("1"));
+    QCOMPARE(settings.changedValue(1), QByteArray("10"));
+    QCOMPARE(settings.changedValue(2), QByteArray("-1.5"));
+    QCOMPARE(settings.changedValue(3), QByteArray("vec3(2.0, 1.1, -0.9)"));
+    QCOMPARE(settings.changedValue(4), QByteArray("luma1"));
+    QVERIFY(settings.changedValue(5).isEmpty());
+}
+
+/**
+ * @brief The index only keeps a hash of the comments, their words must still match after a reparse.
+ */
+void TestShaderSettings::indexKeepsCommentWords() {
+    SettingsIndex index;
+    for (int parse = 0; parse < 2; ++parse) {
+        ShaderSettings settings(settingsBuffer(2, 2));
+        index.beginUpdate();
+        for (int i = 0; i < settings.settings().size(); ++i) {
+            const ShaderSettings::Setting &setting = settings.settings().at(i);
+            index.update(QString::fromUtf8(setting.name), QString::fromUtf8(setting.shader), settings.tooltipView(i));
+        }
+        index.endUpdate();
+        QCOMPARE(index.match("slower").size(), 4);
+        QCOMPARE(index.match("colors s1").size(), 1);
+    }
+}
+
+/**
+ * @brief What parseShadersText() used to do, render the HTML tooltip of every shader and setting.
+ */
+void TestShaderSettings::eagerTooltips() {
+    const QByteArray text(settingsBuffer(60, 12));
+    QBENCHMARK {
+        ShaderSettings settings(text);
+        QStringList tooltips;
+        for (int i = 0; i < settings.settings().size(); ++i) {
+            tooltips.append(SettingItem::renderTooltip(settings.tooltip(i), settings.settings().at(i).type == ShaderSettings::Enabled));
+        }
+    }
+}
+
+/**
+ * @brief What parseShadersText() does now, the index gets views of the comments, the HTML is rendered on hover.
+ */
+void TestShaderSettings::lazyTooltips() {
+    const QByteArray text(settingsBuffer(60, 12));
+    SettingsIndex index;
+    QBENCHMARK {
+        ShaderSettings settings(text);
+        index.beginUpdate();
+        for (int i = 0; i < settings.settings().size(); ++i) {
+            const ShaderSettings::Setting &setting = settings.settings().at(i);
+            index.update(QString::fromUtf8(setting.name), QString::fromUtf8(setting.shader), settings.tooltipView(i));
+        }
+        index.endUpdate();
+    }
+}
+
+/**
+ * @brief Heap kept by the rendered tooltips of every shader and setting, see eagerTooltips().
+ */
+void TestShaderSettings::eagerTooltipsHeap() {
+    if (!heapInUse()) {
+        QSKIP("The heap in use is only known with glibc 2.33 or newer.");
+    }
+    const QByteArray text(settingsBuffer(60, 12));
+    qint64 before = heapInUse();
+    ShaderSettings settings(text);
+    QStringList tooltips;
+    for (int i = 0; i < settings.settings().size(); ++i) {
+        tooltips.append(SettingItem::renderTooltip(settings.tooltip(i), settings.settings().at(i).type == ShaderSettings::Enabled));
+    }
+    QTest::setBenchmarkResult(heapInUse() - before, QTest::BytesAllocated);
+}
+
+/**
+ * @brief Heap kept by the search index, see lazyTooltips().
+ */
+void TestShaderSettings::lazyTooltipsHeap() {
+    if (!heapInUse()) {
+        QSKIP("The heap in use is only known with glibc 2.33 or newer.");
+    }
+    const QByteArray text(settingsBuffer(60, 12));
+    qint64 before = heapInUse();
+    ShaderSettings settings(text);
+    SettingsIndex index;
+    index.beginUpdate();
+    for (int i = 0; i < settings.settings().size(); ++i) {
+        const ShaderSettings::Setting &setting = settings.settings().at(i);
+        index.update(QString::fromUtf8(setting.name), QString::fromUtf8(setting.shader), settings.tooltipView(i));
+    }
+    index.endUpdate();
+    QTest::setBenchmarkResult(heapInUse() - before, QTest::BytesAllocated);
+}
+
+QTEST_GUILESS_MAIN(TestShaderSettings)
+#include "tst_shadersettings.moc"
@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2022  kevinlekiller
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WhitelistMatcher.h"
+#include <QtEndian>
+#include <QtTest>
+
+class TestWhitelistMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void normalize_data();
+    void normalize();
+    void matches_data();
+    void matches();
+    void coveredPatterns();
+    void emptyMatcher();
+    void roundTrip();
+    void malformedLoad();
+    void matchClassNames();
+};
+
+void TestWhitelistMatcher::normalize_data() {
+    QTest::addColumn<QString>("whitelist");
+    QTest::addColumn<QString>("normalized");
+
+    QTest::newRow("empty") << "" << "";
+    QTest::newRow("separators") << "  kate\tkcalc,\n dolphin, " << "dolphin,kate,kcalc";
+    QTest::newRow("case and duplicates") << "Kate,kate,KATE" << "kate";
+    QTest::newRow("quotes") << "\"kate,kcalc\"" << "kate,kcalc";
+    QTest::newRow("double star") << "fire**fox" << "fire*fox";
+    // Compositors reading the //WHITELIST= line compare names literally, covered names must stay.
+    QTest::newRow("covered by prefix") << "steam_app_*,steam_app_570,steam_*" << "steam_*,steam_app_*,steam_app_570";
+    QTest::newRow("prefix and its name") << "steam_*,steam_" << "steam_,steam_*";
+    QTest::newRow("not covered") << "steam_*,steamy,stea?" << "stea?,steam_*,steamy";
+}
+
+void TestWhitelistMatcher::normalize() {
+    QFETCH(QString, whitelist);
+    QFETCH(QString, normalized);
+    QCOMPARE(WhitelistMatcher::normalize(whitelist), normalized);
+    QCOMPARE(WhitelistMatcher::normalize(normalized), normalized);
+}
+
+void TestWhitelistMatcher::matches_data() {
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("match");
+
+    QTest::newRow("name") << "kate" << true;
+    QTest::newRow("name case") << "Kate" << true;
+    QTest::newRow("shorter name") << "kat" << false;
+    QTest::newRow("longer name") << "kated" << false;
+    QTest::newRow("prefix") << "steam_app_42" << true;
+    QTest::newRow("prefix only") << "steam_app_" << true;
+    QTest::newRow("prefix too short") << "steam_ap" << false;
+    QTest::newRow("glob") << "firefox" << true;
+    QTest::newRow("glob middle") << "fire-nightly-fox" << true;
+    QTest::newRow("glob end") << "firefo" << false;
+    QTest::newRow("question mark") << "xyz" << true;
+    QTest::newRow("question mark empty") << "xz" << false;
+    QTest::newRow("empty") << "" << false;
+}
+
+void TestWhitelistMatcher::matches() {
+    QFETCH(QString, name);
+    QFETCH(bool, match);
+    WhitelistMatcher matcher("kate steam_app_* fire*fox x?z");
+    QCOMPARE(matcher.matches(name), match);
+}
+
+/**
+ * @brief Patterns covered by a prefix are only dropped from the compiled trie.
+ */
+void TestWhitelistMatcher::coveredPatterns() {
+    WhitelistMatcher matcher("steam_app_*,steam_app_570,steam_?x,steam_*");
+    QCOMPARE(matcher.serialize(), WhitelistMatcher("steam_*").serialize());
+    QVERIFY(matcher.matches("steam_app_570"));
+    QVERIFY(WhitelistMatcher("steam_*,steam_").matches("steam_"));
+}
+
+void TestWhitelistMatcher::emptyMatcher() {
+    WhitelistMatcher matcher;
+    QVERIFY(matcher.isEmpty());
+    QVERIFY(!matcher.matches("kate"));
+    QVERIFY(WhitelistMatcher(" , ").isEmpty());
+    QVERIFY(!WhitelistMatcher("kate").isEmpty());
+}
+
+void TestWhitelistMatcher::roundTrip() {
+    WhitelistMatcher matcher("kate steam_app_* fire*fox x?z");
+    const QByteArray data(matcher.serialize());
+    QVERIFY(data.startsWith("KWSW"));
+
+    WhitelistMatcher loaded;
+    QVERIFY(loaded.load(data));
+    QCOMPARE(loaded.serialize(), data);
+    const QStringList names = {"kate", "kated", "steam_app_42", "steam_ap", "firefox", "firefo", "xyz", "xz"};
+    for (const QString &name : names) {
+        QCOMPARE(loaded.matches(name), matcher.matches(name));
+    }
+
+    QVERIFY(loaded.load(WhitelistMatcher().serialize()));
+    QVERIFY(loaded.isEmpty());
+}
+
+void TestWhitelistMatcher::malformedLoad() {
+    const QByteArray data(WhitelistMatcher("kate steam_app_* fire*fox").serialize());
+    WhitelistMatcher matcher;
+
+    QVERIFY(!matcher.load(QByteArray()));
+    QVERIFY(!matcher.load(QByteArray("KWSX").append(data.mid(4))));
+    QVERIFY(matcher.isEmpty());
+    for (int size = 0; size < data.size(); ++size) {
+        QVERIFY2(!matcher.load(data.left(size)), qPrintable(QString("Truncated to %1 bytes").arg(size)));
+        QVERIFY(matcher.isEmpty());
+    }
+
+    // Header: magic, version, nodes, edges, globs.
+    const quint32 nodeCount = qFromLittleEndian<quint32>(data.constData() + 8);
+    const int edgesOffset = 20 + static_cast<int>(nodeCount) * 20;
+
+    QByteArray badVersion(data);
+    qToLittleEndian<quint32>(2, badVersion.data() + 4);
+    QVERIFY(!matcher.load(badVersion));
+
+    QByteArray tooManyNodes(data);
+    qToLittleEndian<quint32>(0x7fffffff, tooManyNodes.data() + 8);
+    QVERIFY(!matcher.load(tooManyNodes));
+
+    QByteArray edgeOutOfRange(data);
+    qToLittleEndian<quint32>(nodeCount, edgeOutOfRange.data() + edgesOffset + 4);
+    QVERIFY(!matcher.load(edgeOutOfRange));
+
+    QByteArray edgeByte(data);
+    qToLittleEndian<quint32>(256, edgeByte.data() + edgesOffset);
+    QVERIFY(!matcher.load(edgeByte));
+
+    QByteArray firstEdgeOutOfRange(data);
+    qToLittleEndian<quint32>(0xffffffff, firstEdgeOutOfRange.data() + 20);
+    QVERIFY(!matcher.load(firstEdgeOutOfRange));
+    QVERIFY(matcher.isEmpty());
+}
+
+/**
+ * @brief Match thousands of window class names against a whitelist of names, prefixes and globs.
+ */
+void TestWhitelistMatcher::matchClassNames() {
+    QStringList patterns;
+    for (int i = 0; i < 100; ++i) {
+        patterns.append(QString("org.kde.app%1").arg(i));
+    }
+    patterns << "steam_app_*" << "firefox*" << "*.exe" << "jetbrains-*-ce" << "wine?";
+    WhitelistMatcher matcher(patterns.join(','));
+
+    QStringList names;
+    for (int i = 0; i < 5000; ++i) {
+        switch (i % 5) {
+        case 0:
+            names.append(QString("org.kde.app%1").arg(i % 200));
+            break;
+        case 1:
+            names.append(QString("steam_app_%1").arg(i));
+            break;
+        case 2:
+            names.append(QString("game%1.exe").arg(i));
+            break;
+        case 3:
+            names.append(QString("jetbrains-tool%1-ce").arg(i));
+            break;
+        default:
+            names.append(QString("unlisted.application.%1").arg(i));
+            break;
+        }
+    }
+
+    int matched = 0;
+    QBENCHMARK {
+        matched = 0;
+        for (const QString &name : names) {
+            matched += matcher.matches(name);
+        }
+    }
+    // Half of the org.kde names, all of the steam, exe and jetbrains names.
+    QCOMPARE(matched, 500 + 3000);
+}
+
+QTEST_GUILESS_MAIN(TestWhitelistMatcher)
+#include "tst_whitelistmatcher.moc"